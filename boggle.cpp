@@ -5,6 +5,7 @@
  */
  
 #include <cctype>
+#include <fstream>
 #include <iostream>
 using namespace std;
 
@@ -16,6 +17,8 @@ using namespace std;
 #include "set.h"
 #include "vector.h"
 #include "lexicon.h"
+#include "hashmap.h"
+#include "hashset.h"
 #include "coord.h" // Copied/Imported from Dominosa assignment
 
 const string kEnglishLexiconFilename = "EnglishWords.dat";
@@ -26,6 +29,22 @@ const int kBigBoggleDim = 5;
 const int kMinGuessLength = 4;
 const int highlightPause = 100;
 
+/*
+ * A single guess pulled from a log of a recorded game. The board is stored as its
+ * letters in row-major order (16 letters for standard Boggle, 25 for Big Boggle),
+ * which also serves as the key used to group guesses made against the same board.
+ */
+struct recordedGuess {
+    string board;
+    string guess;
+};
+
+// The outcome of checking one recorded guess: whether it was legal and what it scored.
+struct guessVerdict {
+    bool isValid;
+    int score;
+};
+
 const string kStandardCubes[16] = {
    "AAEEGN", "ABBJOO", "ACHOPS", "AFFKPS",
    "AOOTTW", "CIMOTU", "DEILRX", "DELRVY",
@@ -65,6 +84,13 @@ static void generateAllPossibleWords(const Grid<char> & boggleBoard, Set<string>
                                      const Lexicon & english, int rowIndex, int colIndex, string buildingWord,
                                      Set<coord> wordPath);
 static bool isShiftValid(const Grid<char> & boggleBoard, int initRow, int initCol, int deltRow, int deltCol);
+static void replayRecordedGames(const Lexicon & english);
+static Vector<guessVerdict> validateRecordedGuesses(const Vector<recordedGuess> & guesses, const Lexicon & english);
+static bool makeBoardFromLetters(const string & letters, Grid<char> & boggleBoard);
+static void findAllWordsHeadless(const Grid<char> & boggleBoard, const Lexicon & english, HashSet<string> & wordsOnBoard);
+static void findWordsFromCube(const Grid<char> & boggleBoard, const Lexicon & english, int rowIndex, int colIndex,
+                              string & buildingWord, Grid<bool> & usedCubes, HashSet<string> & wordsOnBoard);
+static int scoreForWord(const string & word);
 
 
 // Welcomes the user to the game.
@@ -519,6 +545,166 @@ static bool isShiftValid(const Grid<char> & boggleBoard, int initRow, int initCo
     return (( (deltRow != 0) || (deltCol != 0) ) && boggleBoard.inBounds(initRow + deltRow, initCol + deltCol));
 }
 
+/*
+ * replayRecordedGames() reads a log of guesses made in recorded games and writes out
+ * whether each guess was legal and what it scored, without opening the game window.
+ *
+ * Every line of the log holds a board's letters (row-major, no spaces) followed by
+ * one guess made against that board. Each line of the results file repeats the board
+ * and guess and appends 1 or 0 for validity and the score of the guess.
+ */
+
+static void replayRecordedGames(const Lexicon & english) {
+    ifstream logFile;
+    while (true) {
+        logFile.open(getLine("Enter the name of the guess log: ").c_str());
+        if (!logFile.fail()) break;
+        logFile.clear();
+        cout << "Unable to open that file. Try again." << endl;
+    }
+    Vector<recordedGuess> guesses;
+    recordedGuess nextGuess;
+    while (logFile >> nextGuess.board >> nextGuess.guess) {
+        guesses.add(nextGuess);
+    }
+    logFile.close();
+
+    Vector<guessVerdict> verdicts = validateRecordedGuesses(guesses, english);
+    ofstream resultsFile;
+    while (true) {
+        resultsFile.open(getLine("Enter the name of the results file: ").c_str());
+        if (!resultsFile.fail()) break;
+        resultsFile.clear();
+        cout << "Unable to create that file. Try again." << endl;
+    }
+    int validGuesses = 0;
+    int totalScore = 0;
+    for (int i = 0; i < guesses.size(); i++) {
+        resultsFile << guesses[i].board << " " << guesses[i].guess << " "
+                    << (verdicts[i].isValid ? 1 : 0) << " " << verdicts[i].score << "\n";
+        if (verdicts[i].isValid) validGuesses++;
+        totalScore += verdicts[i].score;
+    }
+    resultsFile.close();
+    if (resultsFile.fail()) {
+        cout << "Unable to write all of the results to that file." << endl;
+        return;
+    }
+    cout << "Checked " << guesses.size() << " guesses: " << validGuesses
+         << " were valid, for a total of " << totalScore << " points." << endl;
+}
+
+/*
+ * validateRecordedGuesses() is the headless, bulk counterpart of tryPlayerGuess(). It
+ * never touches the display, so it can be used to check very large numbers of guesses.
+ *
+ * Rather than searching the board once per guess, the guesses are first grouped by the
+ * board they were made against. Every distinct board is then solved exactly once, and
+ * the words found are kept in a HashSet, so checking a guess costs a single hash lookup.
+ *
+ * The returned vector lines up with the guesses passed in: the verdict at index i
+ * belongs to the guess at index i. Guesses against malformed boards are never valid.
+ */
+
+static Vector<guessVerdict> validateRecordedGuesses(const Vector<recordedGuess> & guesses, const Lexicon & english) {
+    HashMap<string, Vector<int> > guessesByBoard;
+    Vector<string> distinctBoards;
+    for (int i = 0; i < guesses.size(); i++) {
+        if (!guessesByBoard.containsKey(guesses[i].board)) {
+            distinctBoards.add(guesses[i].board);
+        }
+        guessesByBoard[guesses[i].board].add(i);
+    }
+
+    Vector<guessVerdict> verdicts(guesses.size());
+    for (string letters : distinctBoards) {
+        Grid<char> boggleBoard;
+        HashSet<string> wordsOnBoard;
+        if (makeBoardFromLetters(letters, boggleBoard)) {
+            findAllWordsHeadless(boggleBoard, english, wordsOnBoard);
+        }
+        for (int index : guessesByBoard[letters]) {
+            string guess = toUpperCase(guesses[index].guess);
+            verdicts[index].isValid = wordsOnBoard.contains(guess);
+            verdicts[index].score = verdicts[index].isValid ? scoreForWord(guess) : 0;
+        }
+    }
+    return verdicts;
+}
+
+/*
+ * makeBoardFromLetters() fills a grid from a row-major string of letters. It returns
+ * false if the string is not the size of a standard or Big Boggle board, or if it
+ * contains anything other than letters.
+ */
+
+static bool makeBoardFromLetters(const string & letters, Grid<char> & boggleBoard) {
+    int dim;
+    if (letters.size() == kNormalBoggleDim * kNormalBoggleDim) {
+        dim = kNormalBoggleDim;
+    } else if (letters.size() == kBigBoggleDim * kBigBoggleDim) {
+        dim = kBigBoggleDim;
+    } else return false;
+    boggleBoard.resize(dim, dim);
+    for (int i = 0; i < dim * dim; i++) {
+        unsigned char letter = letters.at(i);
+        if (!isalpha(letter)) return false;
+        boggleBoard[i / dim][i % dim] = toupper(letter);
+    }
+    return true;
+}
+
+/*
+ * findAllWordsHeadless() collects every legal word on the board into wordsOnBoard. It
+ * is the same exhaustive search as computerTurn(), minus the display updates. The word
+ * being built and the cubes in use are shared across the whole search and undone on
+ * the way back out, instead of being copied into every recursive call.
+ */
+
+static void findAllWordsHeadless(const Grid<char> & boggleBoard, const Lexicon & english, HashSet<string> & wordsOnBoard) {
+    Grid<bool> usedCubes(boggleBoard.numRows(), boggleBoard.numCols());
+    string buildingWord;
+    for (int i = 0; i < boggleBoard.numRows(); i++) {
+        for (int j = 0; j < boggleBoard.numCols(); j++) {
+            findWordsFromCube(boggleBoard, english, i, j, buildingWord, usedCubes, wordsOnBoard);
+        }
+    }
+}
+
+/*
+ * findWordsFromCube() is the recursive step of findAllWordsHeadless(). It extends the word
+ * built so far with the cube at (rowIndex, colIndex), records it if it is a legal word,
+ * and keeps exploring unused neighbours for as long as the word is an english prefix.
+ */
+
+static void findWordsFromCube(const Grid<char> & boggleBoard, const Lexicon & english, int rowIndex, int colIndex,
+                              string & buildingWord, Grid<bool> & usedCubes, HashSet<string> & wordsOnBoard) {
+    buildingWord += boggleBoard[rowIndex][colIndex];
+    usedCubes[rowIndex][colIndex] = true;
+    if (buildingWord.size() >= kMinGuessLength && english.contains(buildingWord)) {
+        wordsOnBoard.add(buildingWord);
+    }
+    if (english.containsPrefix(buildingWord)) {
+        for (int i = -1; i <= 1; i++) {
+            for (int j = -1; j <= 1; j++) {
+                if (isShiftValid(boggleBoard, rowIndex, colIndex, i, j)
+                        && !usedCubes[rowIndex + i][colIndex + j]) {
+                    findWordsFromCube(boggleBoard, english, rowIndex + i, colIndex + j,
+                                      buildingWord, usedCubes, wordsOnBoard);
+                }
+            }
+        }
+    }
+    usedCubes[rowIndex][colIndex] = false;
+    buildingWord.erase(buildingWord.size() - 1);
+}
+
+// scoreForWord() applies the Boggle scoring rule: a 4-letter word is worth 1 point, a 5-letter word 2, and so on.
+
+static int scoreForWord(const string & word) {
+    return word.size() - kMinGuessLength + 1;
+}
+
 /*
  * This is the main method for the Boggle Program.
  *
@@ -537,13 +723,20 @@ static bool isShiftValid(const Grid<char> & boggleBoard, int initRow, int initCo
  *
  * The user is then asked to play again. If they say yes, another board is made,
  * and the computer and user have another turn. if not, the program ends.
+ *
+ * Before any of this, the user may instead choose to check a log of recorded guesses,
+ * in which case no window is opened and the program ends once the log is checked.
  */
 
 int main() {
+   Lexicon english (kEnglishLexiconFilename);
+   if (getYesOrNo("Do you want to check a log of recorded guesses instead of playing?")) {
+      replayRecordedGames(english);
+      return 0;
+   }
    GWindow gw(kBoggleWindowWidth, kBoggleWindowHeight);
    Grid<char> boggleBoard;
    Set<string> playerAnswers;
-   Lexicon english (kEnglishLexiconFilename);
    initGBoggle(gw);
    welcome();
    if (getYesOrNo("Do you need instructions?")) {
@@ -0,0 +1,288 @@
+/**
+ * File: maze-bitplanes.h
+ * ----------------------
+ * Defines a compact representation of a rectangular maze for the headless
+ * generators, in which every wall is a single bit.
+ */
+
+#ifndef _maze_bitplanes_
+#define _maze_bitplanes_
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Cells are identified by their index, numbered row by row from 0 in the top
+ * left corner, and walls by the index of the cell to their north or west
+ * shifted left by one, with the low bit giving the side of that cell the wall
+ * is on. Every interior wall of a maze therefore has exactly one index.
+ */
+static const int kEastWall = 0;
+static const int kSouthWall = 1;
+
+/*
+ * Function: makeWallIndex
+ * Usage: uint64_t wallIndex = makeWallIndex(cellIndex, kSouthWall);
+ * -----------------------------------------------------------------
+ * Returns the index of the wall on the given side of a cell.
+ */
+inline uint64_t makeWallIndex(uint64_t cellIndex, int side) {
+    return (cellIndex << 1) | side;
+}
+
+/*
+ * Class: MazeBitplanes
+ * --------------------
+ * Stores which walls of a width-by-height maze are still standing as two
+ * planes of bits: one for the wall on the east side of every cell and one for
+ * the wall on the south side. A set bit means the wall is up. The east walls
+ * of the last column and the south walls of the last row are the border of
+ * the maze and are never removed.
+ *
+ * Each row of a plane starts on a fresh 64-bit word, so the maze takes a
+ * little over two bits per cell, a row can be read or written as a unit, and
+ * threads working on different rows never share a word. The planes are
+ * interleaved row by row: the east words of row 0, then the south words of
+ * row 0, then the east words of row 1, and so on. This is also the layout of
+ * a maze file (see maze-file.h), so a mapped file can be used in place.
+ */
+class MazeBitplanes {
+public:
+
+    /*
+     * Constructor: MazeBitplanes
+     * Usage: MazeBitplanes maze(width, height);
+     * -----------------------------------------
+     * Creates a maze of the given size with every wall standing.
+     */
+    MazeBitplanes(uint64_t width = 0, uint64_t height = 0);
+
+    /*
+     * Copy constructor and assignment operator
+     * ----------------------------------------
+     * Copying a maze copies its walls, unless the maze is attached to memory
+     * it does not own, in which case the copy is attached to the same memory.
+     */
+    MazeBitplanes(const MazeBitplanes & src);
+    MazeBitplanes & operator=(const MazeBitplanes & src);
+
+    /*
+     * Method: resize
+     * Usage: maze.resize(width, height);
+     * ----------------------------------
+     * Changes the size of the maze and puts every wall back up.
+     */
+    void resize(uint64_t width, uint64_t height);
+
+    /*
+     * Method: attach
+     * Usage: maze.attach(words, width, height);
+     * -----------------------------------------
+     * Makes the maze use height * 2 * wordsPerRow() words starting at words,
+     * laid out as described above, instead of memory of its own. The memory
+     * must outlive the maze or the next call to resize or attach.
+     */
+    void attach(uint64_t *words, uint64_t width, uint64_t height);
+
+    /*
+     * Methods: width, height, numCells, wordsPerRow
+     * Usage: uint64_t numCells = maze.numCells();
+     * -------------------------------------------
+     * Return the size of the maze, and the number of 64-bit words taken up by
+     * one row of either plane.
+     */
+    uint64_t width() const;
+    uint64_t height() const;
+    uint64_t numCells() const;
+    uint64_t wordsPerRow() const;
+
+    /*
+     * Methods: hasEastWall, hasSouthWall
+     * Usage: if (maze.hasEastWall(row, col)) ...
+     * ------------------------------------------
+     * Return whether the wall on the east or south side of a cell is up.
+     */
+    bool hasEastWall(uint64_t row, uint64_t col) const;
+    bool hasSouthWall(uint64_t row, uint64_t col) const;
+
+    /*
+     * Methods: removeEastWall, removeSouthWall
+     * Usage: maze.removeSouthWall(row, col);
+     * --------------------------------------
+     * Knock down the wall on the east or south side of a cell.
+     */
+    void removeEastWall(uint64_t row, uint64_t col);
+    void removeSouthWall(uint64_t row, uint64_t col);
+
+    /*
+     * Methods: hasWall, removeWall
+     * Usage: maze.removeWall(wallIndex);
+     * ----------------------------------
+     * Look up or knock down a wall given its index (see makeWallIndex).
+     */
+    bool hasWall(uint64_t wallIndex) const;
+    void removeWall(uint64_t wallIndex);
+
+    /*
+     * Methods: eastRow, southRow
+     * Usage: const uint64_t *bits = maze.eastRow(row);
+     * ------------------------------------------------
+     * Return the wordsPerRow() words holding one row of a plane. Bit c % 64 of
+     * word c / 64 belongs to the cell in column c.
+     */
+    uint64_t *eastRow(uint64_t row);
+    const uint64_t *eastRow(uint64_t row) const;
+    uint64_t *southRow(uint64_t row);
+    const uint64_t *southRow(uint64_t row) const;
+
+    /*
+     * Method: memoryUsage
+     * Usage: uint64_t bytes = maze.memoryUsage();
+     * -------------------------------------------
+     * Returns the number of bytes taken up by the two planes.
+     */
+    uint64_t memoryUsage() const;
+
+private:
+    uint64_t mazeWidth;
+    uint64_t mazeHeight;
+    uint64_t rowWords;
+    uint64_t *planes;
+    std::vector<uint64_t> ownedPlanes;
+};
+
+/*
+ * Class: MazeRowSink
+ * ------------------
+ * Something that receives a maze one finished row at a time, such as a maze
+ * file being written or a display. Generators that stream their output hand
+ * each row to a sink as soon as none of its walls can change again.
+ */
+class MazeRowSink {
+public:
+    virtual ~MazeRowSink() {}
+
+    /*
+     * Method: acceptRow
+     * Usage: if (!sink.acceptRow(row, eastWords, southWords)) break;
+     * --------------------------------------------------------------
+     * Receives the east and south words of the next row, laid out like one
+     * row of a MazeBitplanes. Returns false to ask the generator to stop.
+     */
+    virtual bool acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords) = 0;
+};
+
+/*
+ * Implementation notes
+ * --------------------
+ * Every accessor is a shift and a mask, and the generators call them once per
+ * wall, so they are all defined inline here.
+ */
+
+inline MazeBitplanes::MazeBitplanes(uint64_t width, uint64_t height) {
+    resize(width, height);
+}
+
+inline MazeBitplanes::MazeBitplanes(const MazeBitplanes & src) {
+    *this = src;
+}
+
+inline MazeBitplanes & MazeBitplanes::operator=(const MazeBitplanes & src) {
+    if (this == &src) return *this;
+    mazeWidth = src.mazeWidth;
+    mazeHeight = src.mazeHeight;
+    rowWords = src.rowWords;
+    ownedPlanes = src.ownedPlanes;
+    planes = src.ownedPlanes.empty() ? src.planes : ownedPlanes.data();
+    return *this;
+}
+
+inline void MazeBitplanes::resize(uint64_t width, uint64_t height) {
+    mazeWidth = width;
+    mazeHeight = height;
+    rowWords = (width + 63) / 64;
+    ownedPlanes.assign(2 * rowWords * height, ~0ULL);
+    planes = ownedPlanes.data();
+}
+
+inline void MazeBitplanes::attach(uint64_t *words, uint64_t width, uint64_t height) {
+    mazeWidth = width;
+    mazeHeight = height;
+    rowWords = (width + 63) / 64;
+    ownedPlanes.clear();
+    ownedPlanes.shrink_to_fit();
+    planes = words;
+}
+
+inline uint64_t MazeBitplanes::width() const {
+    return mazeWidth;
+}
+
+inline uint64_t MazeBitplanes::height() const {
+    return mazeHeight;
+}
+
+inline uint64_t MazeBitplanes::numCells() const {
+    return mazeWidth * mazeHeight;
+}
+
+inline uint64_t MazeBitplanes::wordsPerRow() const {
+    return rowWords;
+}
+
+inline bool MazeBitplanes::hasEastWall(uint64_t row, uint64_t col) const {
+    return (planes[2 * row * rowWords + col / 64] >> (col % 64)) & 1;
+}
+
+inline bool MazeBitplanes::hasSouthWall(uint64_t row, uint64_t col) const {
+    return (planes[(2 * row + 1) * rowWords + col / 64] >> (col % 64)) & 1;
+}
+
+inline void MazeBitplanes::removeEastWall(uint64_t row, uint64_t col) {
+    planes[2 * row * rowWords + col / 64] &= ~(1ULL << (col % 64));
+}
+
+inline void MazeBitplanes::removeSouthWall(uint64_t row, uint64_t col) {
+    planes[(2 * row + 1) * rowWords + col / 64] &= ~(1ULL << (col % 64));
+}
+
+inline bool MazeBitplanes::hasWall(uint64_t wallIndex) const {
+    uint64_t cellIndex = wallIndex >> 1;
+    uint64_t row = cellIndex / mazeWidth;
+    uint64_t col = cellIndex % mazeWidth;
+    if ((wallIndex & 1) == kEastWall) return hasEastWall(row, col);
+    return hasSouthWall(row, col);
+}
+
+inline void MazeBitplanes::removeWall(uint64_t wallIndex) {
+    uint64_t cellIndex = wallIndex >> 1;
+    uint64_t row = cellIndex / mazeWidth;
+    uint64_t col = cellIndex % mazeWidth;
+    if ((wallIndex & 1) == kEastWall) {
+        removeEastWall(row, col);
+    } else {
+        removeSouthWall(row, col);
+    }
+}
+
+inline uint64_t *MazeBitplanes::eastRow(uint64_t row) {
+    return planes + 2 * row * rowWords;
+}
+
+inline const uint64_t *MazeBitplanes::eastRow(uint64_t row) const {
+    return planes + 2 * row * rowWords;
+}
+
+inline uint64_t *MazeBitplanes::southRow(uint64_t row) {
+    return planes + (2 * row + 1) * rowWords;
+}
+
+inline const uint64_t *MazeBitplanes::southRow(uint64_t row) const {
+    return planes + (2 * row + 1) * rowWords;
+}
+
+inline uint64_t MazeBitplanes::memoryUsage() const {
+    return 2 * rowWords * mazeHeight * sizeof(uint64_t);
+}
+
+#endif
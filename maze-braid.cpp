@@ -0,0 +1,198 @@
+/**
+ * File: maze-braid.cpp
+ * --------------------
+ * Implements the braiding pass declared in maze-braid.h.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "maze-braid.h"
+#include "maze-metrics.h"
+#include "maze-random.h"
+
+/*
+ * Type: braidBand
+ * ---------------
+ * A band of consecutive rows braided by one thread. aboveRow holds the south words of the row just above the band as they were
+ * before the pass, and deferredWalls the walls the band chose on the north side of its first row, which belong to the band
+ * above and are knocked down after every band has finished.
+ */
+struct braidBand {
+    uint64_t firstRow;
+    uint64_t endRow;
+    vector<uint64_t> aboveRow;
+    vector<uint64_t> deferredWalls;
+    uint64_t wallsRemoved;
+};
+
+//Prototypes
+static void findBandDeadEnds(const MazeBitplanes & maze, braidBand & band, vector<uint64_t> & deadEnds);
+static void braidBandRows(MazeBitplanes & maze, braidBand & band, const vector<uint64_t> & deadEnds, uint64_t seed,
+                          uint64_t threshold);
+static int chooseWall(const MazeBitplanes & maze, const vector<uint64_t> & deadEnds, uint64_t row, uint64_t col,
+                      const vector<uint64_t> & east, const vector<uint64_t> & south, const vector<uint64_t> & north,
+                      uint64_t random);
+static bool isDeadEnd(const MazeBitplanes & maze, const vector<uint64_t> & deadEnds, uint64_t row, uint64_t col);
+static bool testBit(const vector<uint64_t> & words, uint64_t col);
+static void runOnBands(vector<braidBand> & bands, const function<void(braidBand &)> & work);
+static const uint64_t braidSalt = 0x627261696473ULL;
+static const int rowStep[4] = { 0, 1, 0, -1 };
+static const int colStep[4] = { 1, 0, -1, 0 };
+
+/*
+ * The pass runs in two phases. The first finds every dead end and writes it into a bitset laid out like one plane of the maze,
+ * and copies the row above each band; nothing in the maze changes. The second decides, for each dead end that is picked, which
+ * wall to knock down, looking only at that bitset and at copies of the rows taken before they were changed, so the decisions
+ * come out the same however the rows are split. A dead end is picked when the high half of its random number is below the
+ * fraction scaled to 2^32; the low half chooses the wall.
+ */
+uint64_t braidMaze(MazeBitplanes & maze, uint64_t seed, double fraction, int numThreads) {
+    if (fraction <= 0 || maze.numCells() == 0) return 0;
+    uint64_t threshold = fraction >= 1 ? 1ULL << 32 : (uint64_t) (fraction * 4294967296.0);
+    uint64_t numBands = numThreads < 1 ? 1 : numThreads;
+    if (numBands > maze.height()) numBands = maze.height();
+    vector<braidBand> bands(numBands);
+    for (uint64_t i = 0; i < numBands; i++) {
+        bands[i].firstRow = maze.height() * i / numBands;
+        bands[i].endRow = maze.height() * (i + 1) / numBands;
+        bands[i].wallsRemoved = 0;
+    }
+    vector<uint64_t> deadEnds(maze.height() * maze.wordsPerRow());
+    runOnBands(bands, [&](braidBand & band) {
+        findBandDeadEnds(maze, band, deadEnds);
+    });
+    runOnBands(bands, [&](braidBand & band) {
+        braidBandRows(maze, band, deadEnds, seed, threshold);
+    });
+
+    uint64_t wallsRemoved = 0;
+    for (const braidBand & band : bands) {
+        wallsRemoved += band.wallsRemoved;
+        for (uint64_t wallIndex : band.deferredWalls) {
+            if (!maze.hasWall(wallIndex)) continue;
+            maze.removeWall(wallIndex);
+            wallsRemoved++;
+        }
+    }
+    return wallsRemoved;
+}
+
+/*
+ * This method marks the dead ends in one band of rows and saves a copy of the south words of the row above the band.
+ */
+static void findBandDeadEnds(const MazeBitplanes & maze, braidBand & band, vector<uint64_t> & deadEnds) {
+    uint64_t rowWords = maze.wordsPerRow();
+    for (uint64_t row = band.firstRow; row < band.endRow; row++) {
+        for (uint64_t word = 0; word < rowWords; word++) {
+            uint64_t junctions;
+            findDeadEndsAndJunctions(maze, row, word, deadEnds[row * rowWords + word], junctions);
+        }
+    }
+    if (band.firstRow > 0) {
+        const uint64_t *above = maze.southRow(band.firstRow - 1);
+        band.aboveRow.assign(above, above + rowWords);
+    }
+}
+
+/*
+ * This method braids the dead ends in one band of rows. Before a row is changed, its east and south words are copied, and the
+ * south words of the row before it are kept from the previous step, so every cell's walls are read as they were before the
+ * pass. A wall is only counted as removed if it is still standing, since two neighbouring dead ends can pick the same wall.
+ */
+static void braidBandRows(MazeBitplanes & maze, braidBand & band, const vector<uint64_t> & deadEnds, uint64_t seed,
+                          uint64_t threshold) {
+    uint64_t rowWords = maze.wordsPerRow();
+    vector<uint64_t> east(rowWords);
+    vector<uint64_t> south(rowWords);
+    vector<uint64_t> north = band.aboveRow;
+    for (uint64_t row = band.firstRow; row < band.endRow; row++) {
+        east.assign(maze.eastRow(row), maze.eastRow(row) + rowWords);
+        south.assign(maze.southRow(row), maze.southRow(row) + rowWords);
+        for (uint64_t word = 0; word < rowWords; word++) {
+            uint64_t remaining = deadEnds[row * rowWords + word];
+            while (remaining != 0) {
+                uint64_t col = 64 * word + __builtin_ctzll(remaining);
+                remaining &= remaining - 1;
+                uint64_t random = counterRandom(seed ^ braidSalt, row * maze.width() + col);
+                if ((random >> 32) >= threshold) continue;
+                int direction = chooseWall(maze, deadEnds, row, col, east, south, north, random);
+                if (direction < 0) continue;
+                uint64_t wallRow = direction == 3 ? row - 1 : row;
+                uint64_t wallCol = direction == 2 ? col - 1 : col;
+                int side = direction % 2 == 0 ? kEastWall : kSouthWall;
+                if (direction == 3 && row == band.firstRow) {
+                    band.deferredWalls.push_back(makeWallIndex(wallRow * maze.width() + wallCol, side));
+                } else if (side == kEastWall && maze.hasEastWall(wallRow, wallCol)) {
+                    maze.removeEastWall(wallRow, wallCol);
+                    band.wallsRemoved++;
+                } else if (side == kSouthWall && maze.hasSouthWall(wallRow, wallCol)) {
+                    maze.removeSouthWall(wallRow, wallCol);
+                    band.wallsRemoved++;
+                }
+            }
+        }
+        north.swap(south);
+    }
+}
+
+/*
+ * This method returns the direction of the wall to knock down at the dead end in the given cell, numbering directions east,
+ * south, west, north, or -1 if the cell has no wall that can come down. Walls into other dead ends are preferred. east and
+ * south hold the cell's row, and north the row above it, as they were before the pass.
+ */
+static int chooseWall(const MazeBitplanes & maze, const vector<uint64_t> & deadEnds, uint64_t row, uint64_t col,
+                      const vector<uint64_t> & east, const vector<uint64_t> & south, const vector<uint64_t> & north,
+                      uint64_t random) {
+    bool closed[4];
+    closed[0] = col + 1 < maze.width() && testBit(east, col);
+    closed[1] = row + 1 < maze.height() && testBit(south, col);
+    closed[2] = col > 0 && testBit(east, col - 1);
+    closed[3] = row > 0 && testBit(north, col);
+    int candidates[4];
+    int numCandidates = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        if (closed[direction] && isDeadEnd(maze, deadEnds, row + rowStep[direction], col + colStep[direction])) {
+            candidates[numCandidates++] = direction;
+        }
+    }
+    if (numCandidates == 0) {
+        for (int direction = 0; direction < 4; direction++) {
+            if (closed[direction]) candidates[numCandidates++] = direction;
+        }
+    }
+    if (numCandidates == 0) return -1;
+    return candidates[(random & 0xffffffff) % numCandidates];
+}
+
+/*
+ * This method returns whether the given cell was a dead end before the pass.
+ */
+static bool isDeadEnd(const MazeBitplanes & maze, const vector<uint64_t> & deadEnds, uint64_t row, uint64_t col) {
+    return (deadEnds[row * maze.wordsPerRow() + col / 64] >> (col % 64)) & 1;
+}
+
+/*
+ * This method returns bit col % 64 of word col / 64 of a copied row.
+ */
+static bool testBit(const vector<uint64_t> & words, uint64_t col) {
+    return (words[col / 64] >> (col % 64)) & 1;
+}
+
+/*
+ * This method does the given work on every band, giving each band after the first a thread of its own, and returns once all of
+ * them are done.
+ */
+static void runOnBands(vector<braidBand> & bands, const function<void(braidBand &)> & work) {
+    vector<thread> workers;
+    for (size_t i = 1; i < bands.size(); i++) {
+        workers.push_back(thread(work, ref(bands[i])));
+    }
+    work(bands[0]);
+    for (thread & worker : workers) {
+        worker.join();
+    }
+}
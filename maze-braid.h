@@ -0,0 +1,37 @@
+/**
+ * File: maze-braid.h
+ * ------------------
+ * Declares a pass that turns a perfect maze stored as MazeBitplanes into a
+ * braided one, with loops in place of some of its dead ends.
+ */
+
+#ifndef _maze_braid_
+#define _maze_braid_
+
+#include <cstdint>
+#include "maze-bitplanes.h"
+
+/*
+ * Function: braidMaze
+ * Usage: uint64_t removed = braidMaze(maze, seed, fraction, numThreads);
+ * ----------------------------------------------------------------------
+ * Picks about the given fraction of the maze's dead ends at random and knocks
+ * down one more wall at each of them, which joins the dead end to a
+ * neighbouring cell and closes a loop. A wall into another dead end is chosen
+ * whenever there is one, since that removes both dead ends at once, so the
+ * fraction of dead ends removed is at least the fraction asked for. A
+ * fraction of 0 leaves the maze alone and a fraction of 1 leaves no dead ends
+ * in any maze at least two cells wide and tall. Returns the number of walls
+ * removed.
+ *
+ * Every choice is made from the maze as it was before the pass and from the
+ * seed alone, so the result does not depend on numThreads. The dead ends are
+ * found 64 cells at a time, exactly as measureMaze counts them (see
+ * maze-metrics.h), and the rows are split into one band per thread. Each band
+ * only ever writes to its own rows; a wall it chooses on the north side of its
+ * first row belongs to the band above, and is knocked down once every band has
+ * finished. Needs one bit per cell beyond the maze itself.
+ */
+uint64_t braidMaze(MazeBitplanes & maze, uint64_t seed, double fraction, int numThreads);
+
+#endif
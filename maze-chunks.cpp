@@ -0,0 +1,273 @@
+/**
+ * File: maze-chunks.cpp
+ * ---------------------
+ * Implements the chunked infinite maze declared in maze-chunks.h.
+ */
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "maze-chunks.h"
+#include "maze-disjoint-set.h"
+#include "maze-random.h"
+
+/*
+ * Type: regionTree
+ * ----------------
+ * Which borders between the chunks of one region have doors. eastDoor[y][x] is the border on the east side of the chunk in
+ * row y and column x of the region, and southDoor[y][x] the border on its south side.
+ */
+struct regionTree {
+    bool eastDoor[kRegionSize][kRegionSize];
+    bool southDoor[kRegionSize][kRegionSize];
+};
+
+/*
+ * Type: regionEdge
+ * ----------------
+ * A border between two chunks of a region, paired with the random weight that decides when Kruskal's algorithm considers it.
+ */
+struct regionEdge {
+    uint64_t weight;
+    int chunkIndex;
+    int side;
+};
+
+//Prototypes
+static void buildRegionTree(uint64_t seed, int64_t regionX, int64_t regionY, regionTree & tree);
+static bool hasEastDoor(uint64_t seed, int64_t chunkX, int64_t chunkY, const regionTree & tree);
+static bool hasSouthDoor(uint64_t seed, int64_t chunkX, int64_t chunkY, const regionTree & tree);
+static void carveChunk(MazeBitplanes & maze, MazeRandom & generator);
+static uint64_t hashPosition(uint64_t seed, uint64_t tag, int64_t x, int64_t y);
+static bool operator<(const regionEdge & one, const regionEdge & two);
+static const int regionShift = 4;
+static const uint64_t chunkTag = 1;
+static const uint64_t eastDoorTag = 2;
+static const uint64_t southDoorTag = 3;
+static const uint64_t regionTreeTag = 4;
+static const uint64_t regionEastTag = 5;
+static const uint64_t regionSouthTag = 6;
+
+/*
+ * Chunk and region coordinates are related by an arithmetic shift, which rounds toward negative infinity, so the chunks of a
+ * region are always the kRegionSize x kRegionSize block at its corner, even for negative coordinates. Only the region holding
+ * this chunk needs its tree built: the doors leading out of the region come straight from a hash, and the west and north
+ * borders are the east and south borders of the neighbouring chunks.
+ */
+void generateChunk(uint64_t seed, int64_t chunkX, int64_t chunkY, mazeChunk & chunk) {
+    chunk.chunkX = chunkX;
+    chunk.chunkY = chunkY;
+    if (chunk.maze.width() != (uint64_t) kChunkSize || chunk.maze.height() != (uint64_t) kChunkSize) {
+        chunk.maze.resize(kChunkSize, kChunkSize);
+    } else {
+        fill(chunk.maze.eastRow(0), chunk.maze.eastRow(0) + 2 * kChunkSize * chunk.maze.wordsPerRow(), ~0ULL);
+    }
+    MazeRandom generator(hashPosition(seed, chunkTag, chunkX, chunkY));
+    carveChunk(chunk.maze, generator);
+
+    regionTree tree;
+    buildRegionTree(seed, chunkX >> regionShift, chunkY >> regionShift, tree);
+    if (hasEastDoor(seed, chunkX, chunkY, tree)) {
+        chunk.maze.removeEastWall(hashPosition(seed, eastDoorTag, chunkX, chunkY) % kChunkSize, kChunkSize - 1);
+    }
+    if (hasSouthDoor(seed, chunkX, chunkY, tree)) {
+        chunk.maze.removeSouthWall(kChunkSize - 1, hashPosition(seed, southDoorTag, chunkX, chunkY) % kChunkSize);
+    }
+    chunk.westDoor = -1;
+    if (hasEastDoor(seed, chunkX - 1, chunkY, tree)) {
+        chunk.westDoor = hashPosition(seed, eastDoorTag, chunkX - 1, chunkY) % kChunkSize;
+    }
+    chunk.northDoor = -1;
+    if (hasSouthDoor(seed, chunkX, chunkY - 1, tree)) {
+        chunk.northDoor = hashPosition(seed, southDoorTag, chunkX, chunkY - 1) % kChunkSize;
+    }
+}
+
+MazeChunkCache::MazeChunkCache(uint64_t seed, size_t capacity) {
+    mazeSeed = seed;
+    maxChunks = max<size_t>(capacity, 1);
+    numHits = 0;
+    numMisses = 0;
+}
+
+/*
+ * The chunks are kept in a list from most to least recently used, indexed by their coordinates. A hit moves the chunk to the
+ * front of the list. A miss with the cache full moves the last chunk to the front and generates the new chunk over it, which
+ * reuses its planes instead of allocating new ones.
+ */
+const mazeChunk & MazeChunkCache::getChunk(int64_t chunkX, int64_t chunkY) {
+    chunkKey key = { chunkX, chunkY };
+    unordered_map<chunkKey, list<mazeChunk>::iterator, chunkKeyHash>::iterator found = index.find(key);
+    if (found != index.end()) {
+        numHits++;
+        chunks.splice(chunks.begin(), chunks, found->second);
+        return chunks.front();
+    }
+    numMisses++;
+    if (chunks.size() >= maxChunks) {
+        chunkKey evicted = { chunks.back().chunkX, chunks.back().chunkY };
+        index.erase(evicted);
+        chunks.splice(chunks.begin(), chunks, prev(chunks.end()));
+    } else {
+        chunks.push_front(mazeChunk());
+    }
+    generateChunk(mazeSeed, chunkX, chunkY, chunks.front());
+    index[key] = chunks.begin();
+    return chunks.front();
+}
+
+size_t MazeChunkCache::size() const {
+    return chunks.size();
+}
+
+uint64_t MazeChunkCache::hits() const {
+    return numHits;
+}
+
+uint64_t MazeChunkCache::misses() const {
+    return numMisses;
+}
+
+size_t MazeChunkCache::chunkKeyHash::operator()(const chunkKey & key) const {
+    return ((uint64_t) key.chunkX * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t) key.chunkY * 0xc2b2ae3d27d4eb4fULL);
+}
+
+/*
+ * This method runs Kruskal's algorithm over the chunks of one region, treating each chunk as a single cell and each border
+ * between two chunks as a wall, with weights hashed from the seed and the region's coordinates. The borders it would knock
+ * down are the ones that get doors.
+ */
+static void buildRegionTree(uint64_t seed, int64_t regionX, int64_t regionY, regionTree & tree) {
+    uint64_t regionSeed = hashPosition(seed, regionTreeTag, regionX, regionY);
+    vector<regionEdge> edges;
+    edges.reserve(2 * kRegionSize * (kRegionSize - 1));
+    for (int y = 0; y < kRegionSize; y++) {
+        for (int x = 0; x < kRegionSize; x++) {
+            int chunkIndex = y * kRegionSize + x;
+            tree.eastDoor[y][x] = false;
+            tree.southDoor[y][x] = false;
+            if (x + 1 < kRegionSize) {
+                regionEdge eastEdge = { counterRandom(regionSeed, makeWallIndex(chunkIndex, kEastWall)), chunkIndex, kEastWall };
+                edges.push_back(eastEdge);
+            }
+            if (y + 1 < kRegionSize) {
+                regionEdge southEdge = { counterRandom(regionSeed, makeWallIndex(chunkIndex, kSouthWall)), chunkIndex, kSouthWall };
+                edges.push_back(southEdge);
+            }
+        }
+    }
+    sort(edges.begin(), edges.end());
+    DisjointSet chunkSets(kRegionSize * kRegionSize);
+    int doorsLeft = kRegionSize * kRegionSize - 1;
+    for (size_t i = 0; i < edges.size() && doorsLeft > 0; i++) {
+        int chunkIndex = edges[i].chunkIndex;
+        int y = chunkIndex / kRegionSize;
+        int x = chunkIndex % kRegionSize;
+        if (edges[i].side == kEastWall) {
+            if (chunkSets.merge(chunkIndex, chunkIndex + 1)) {
+                tree.eastDoor[y][x] = true;
+                doorsLeft--;
+            }
+        } else if (chunkSets.merge(chunkIndex, chunkIndex + kRegionSize)) {
+            tree.southDoor[y][x] = true;
+            doorsLeft--;
+        }
+    }
+}
+
+/*
+ * These methods return whether the border on the east or south side of a chunk has a door. A border inside a region is looked
+ * up in that region's tree, which must be the tree of the region holding the chunk; a border between two regions has a door
+ * only if it is the one chunk border picked, by hashing the regions' position, out of the kRegionSize they share. The west and
+ * north borders of a chunk are the east and south borders of its neighbours, which share its region unless they are on the
+ * other side of a region border, so tree is only consulted for borders inside the same region.
+ */
+static bool hasEastDoor(uint64_t seed, int64_t chunkX, int64_t chunkY, const regionTree & tree) {
+    int x = chunkX & (kRegionSize - 1);
+    int y = chunkY & (kRegionSize - 1);
+    if (x + 1 < kRegionSize) return tree.eastDoor[y][x];
+    return (int) (hashPosition(seed, regionEastTag, chunkX >> regionShift, chunkY >> regionShift) % kRegionSize) == y;
+}
+
+static bool hasSouthDoor(uint64_t seed, int64_t chunkX, int64_t chunkY, const regionTree & tree) {
+    int x = chunkX & (kRegionSize - 1);
+    int y = chunkY & (kRegionSize - 1);
+    if (y + 1 < kRegionSize) return tree.southDoor[y][x];
+    return (int) (hashPosition(seed, regionSouthTag, chunkX >> regionShift, chunkY >> regionShift) % kRegionSize) == x;
+}
+
+/*
+ * This method carves a perfect maze into a chunk with the compact form of Eller's algorithm. The cells of each set in the
+ * current row are linked in a circular list in left-to-right order, through left and right, so cells col and col + 1 are in
+ * the same set exactly when right[col] is col + 1. Joining two neighbouring sets splices their lists together. A cell whose
+ * south wall stays up leaves its set, unless it is the last one left in it, and starts the next row in a set of its own; a cell
+ * that is still in a set when the row ends opens downward. On the last row every pair of neighbouring sets is joined.
+ *
+ * Each cell costs two coin flips and a handful of loads and stores, which keeps a chunk around a millisecond. The coin flips
+ * would be mispredicted half the time if they were branched on, so the list updates are made either way, with a mask choosing
+ * between the new links and the old ones.
+ */
+static void carveChunk(MazeBitplanes & maze, MazeRandom & generator) {
+    int left[kChunkSize];
+    int right[kChunkSize];
+    for (int col = 0; col < kChunkSize; col++) {
+        left[col] = col;
+        right[col] = col;
+    }
+    uint64_t bits = 0;
+    int bitsLeft = 0;
+    for (int row = 0; row < kChunkSize; row++) {
+        uint64_t *east = maze.eastRow(row);
+        uint64_t *south = maze.southRow(row);
+        bool isLastRow = row + 1 == kChunkSize;
+        for (int col = 0; col + 1 < kChunkSize; col++) {
+            if (bitsLeft == 0) {
+                bits = generator.next();
+                bitsLeft = 64;
+            }
+            int nextLeft = left[col + 1];
+            int thisRight = right[col];
+            int join = (thisRight != col + 1) & (isLastRow | (int) (bits & 1));
+            bits >>= 1;
+            bitsLeft--;
+            int keep = join - 1;
+            right[nextLeft] = (right[nextLeft] & keep) | (thisRight & ~keep);
+            left[thisRight] = (left[thisRight] & keep) | (nextLeft & ~keep);
+            right[col] = (thisRight & keep) | ((col + 1) & ~keep);
+            left[col + 1] = (nextLeft & keep) | (col & ~keep);
+            east[col / 64] &= ~((uint64_t) join << (col % 64));
+        }
+        if (isLastRow) break;
+        for (int col = 0; col < kChunkSize; col++) {
+            if (bitsLeft == 0) {
+                bits = generator.next();
+                bitsLeft = 64;
+            }
+            int thisLeft = left[col];
+            int thisRight = right[col];
+            int close = (thisLeft != col) & (int) (bits & 1);
+            bits >>= 1;
+            bitsLeft--;
+            int keep = close - 1;
+            right[thisLeft] = (right[thisLeft] & keep) | (thisRight & ~keep);
+            left[thisRight] = (left[thisRight] & keep) | (thisLeft & ~keep);
+            left[col] = (thisLeft & keep) | (col & ~keep);
+            right[col] = (thisRight & keep) | (col & ~keep);
+            south[col / 64] &= ~((uint64_t) (close ^ 1) << (col % 64));
+        }
+    }
+}
+
+/*
+ * This method hashes the seed together with a tag saying what the value is for and a pair of coordinates, using the
+ * counter-based generator from maze-random.h.
+ */
+static uint64_t hashPosition(uint64_t seed, uint64_t tag, int64_t x, int64_t y) {
+    return counterRandom(counterRandom(counterRandom(seed, tag), (uint64_t) x), (uint64_t) y);
+}
+
+static bool operator<(const regionEdge & one, const regionEdge & two) {
+    if (one.weight != two.weight) return one.weight < two.weight;
+    return one.chunkIndex * 2 + one.side < two.chunkIndex * 2 + two.side;
+}
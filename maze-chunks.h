@@ -0,0 +1,138 @@
+/**
+ * File: maze-chunks.h
+ * -------------------
+ * Declares a generator for a maze with no edges, built lazily out of square
+ * chunks, along with a cache that keeps recently used chunks around.
+ */
+
+#ifndef _maze_chunks_
+#define _maze_chunks_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include "maze-bitplanes.h"
+
+/*
+ * Constants
+ * ---------
+ * Every chunk is kChunkSize cells on a side, and chunks are grouped into
+ * regions of kRegionSize chunks on a side (see generateChunk). kRegionSize
+ * must stay a power of two, since chunk coordinates are split into a region
+ * and a position within it with shifts and masks.
+ */
+static const int kChunkSize = 256;
+static const int kRegionSize = 16;
+
+/*
+ * Type: mazeChunk
+ * ---------------
+ * One chunk of an infinite maze. Chunk (chunkX, chunkY) holds the cells in
+ * columns chunkX * kChunkSize through chunkX * kChunkSize + kChunkSize - 1,
+ * and likewise for rows, so chunkX grows to the east and chunkY to the south.
+ * Coordinates may be negative.
+ *
+ * The walls are a kChunkSize-square MazeBitplanes. Unlike a finished maze,
+ * its border is not always closed: the east wall of a cell in the last column
+ * is missing where there is a door into the chunk to the east, and likewise
+ * for the south walls of the last row. The doors in the west and north
+ * borders belong to the neighbouring chunks' planes, so they are repeated
+ * here as the row of the west door and the column of the north door, or -1
+ * where that border has no door.
+ */
+struct mazeChunk {
+    int64_t chunkX;
+    int64_t chunkY;
+    MazeBitplanes maze;
+    int westDoor;
+    int northDoor;
+};
+
+/*
+ * Function: generateChunk
+ * Usage: generateChunk(seed, chunkX, chunkY, chunk);
+ * --------------------------------------------------
+ * Fills chunk with the chunk at the given coordinates of the infinite maze
+ * grown from seed. The result depends only on those three values, so any
+ * chunk can be generated on its own, in any order, and always comes out the
+ * same. Every cell of the infinite maze can be reached from every other.
+ *
+ * Inside a chunk the maze is perfect. Whether a border between two chunks
+ * has a door, and where along the border it is, is decided by hashing the
+ * seed with the border's position, so both chunks always agree. Within a
+ * region of kRegionSize x kRegionSize chunks, the borders with doors form a
+ * random spanning tree of the region's chunks, so a region is a perfect maze
+ * as well. Between two neighbouring regions exactly one of their shared
+ * chunk borders has a door. Loops therefore only ever pass through more than
+ * one region.
+ */
+void generateChunk(uint64_t seed, int64_t chunkX, int64_t chunkY, mazeChunk & chunk);
+
+/*
+ * Class: MazeChunkCache
+ * ---------------------
+ * Keeps the most recently used chunks of one infinite maze, up to a fixed
+ * number of them, and generates the rest on demand.
+ */
+class MazeChunkCache {
+public:
+
+    /*
+     * Constructor: MazeChunkCache
+     * Usage: MazeChunkCache cache(seed, capacity);
+     * --------------------------------------------
+     * Creates an empty cache for the maze grown from seed that holds at most
+     * capacity chunks (and always at least one).
+     */
+    MazeChunkCache(uint64_t seed, size_t capacity);
+
+    /*
+     * Method: getChunk
+     * Usage: const mazeChunk & chunk = cache.getChunk(chunkX, chunkY);
+     * ----------------------------------------------------------------
+     * Returns the chunk at the given coordinates, generating it if it is not
+     * in the cache. If the cache is full, the least recently used chunk is
+     * evicted to make room. The reference stays valid until that chunk is
+     * evicted.
+     */
+    const mazeChunk & getChunk(int64_t chunkX, int64_t chunkY);
+
+    /*
+     * Methods: size, hits, misses
+     * Usage: double hitRate = cache.hits() / double(cache.hits() + cache.misses());
+     * -----------------------------------------------------------------------------
+     * Return the number of chunks held, and how many calls to getChunk found
+     * their chunk in the cache or had to generate it.
+     */
+    size_t size() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+
+    /*
+     * Type: chunkKey
+     * --------------
+     * The coordinates of a chunk, as a key for the index of cached chunks.
+     */
+    struct chunkKey {
+        int64_t chunkX;
+        int64_t chunkY;
+        bool operator==(const chunkKey & other) const {
+            return chunkX == other.chunkX && chunkY == other.chunkY;
+        }
+    };
+    struct chunkKeyHash {
+        size_t operator()(const chunkKey & key) const;
+    };
+
+    uint64_t mazeSeed;
+    size_t maxChunks;
+    uint64_t numHits;
+    uint64_t numMisses;
+    std::list<mazeChunk> chunks;
+    std::unordered_map<chunkKey, std::list<mazeChunk>::iterator, chunkKeyHash> index;
+};
+
+#endif
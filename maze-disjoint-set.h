@@ -0,0 +1,327 @@
+/**
+ * File: maze-disjoint-set.h
+ * -------------------------
+ * Defines a disjoint-set (union-find) structure over cells identified by
+ * their index, which the maze generators use to tell whether two cells are
+ * already part of the same chamber, along with a lock-free version that many
+ * threads can use at once.
+ */
+
+#ifndef _maze_disjoint_set_
+#define _maze_disjoint_set_
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "maze-instrumentation.h"
+
+/*
+ * Class: DisjointSet
+ * ------------------
+ * Keeps track of a partition of the elements 0 through size - 1 into disjoint
+ * sets. Every element starts out in a set of its own; sets are then joined
+ * with merge and queried with find. Uses union by rank and path compression,
+ * so any sequence of operations runs in near-linear time.
+ */
+class DisjointSet {
+public:
+
+    /*
+     * Constructor: DisjointSet
+     * Usage: DisjointSet chambers(numCells);
+     * --------------------------------------
+     * Creates a structure holding the elements 0 through size - 1, each in
+     * its own set.
+     */
+    explicit DisjointSet(uint64_t size = 0);
+
+    /*
+     * Method: reset
+     * Usage: chambers.reset(numCells);
+     * --------------------------------
+     * Discards every merge and resizes the structure to hold size elements,
+     * each in its own set.
+     */
+    void reset(uint64_t size);
+
+    /*
+     * Method: find
+     * Usage: uint64_t root = chambers.find(cellIndex);
+     * ------------------------------------------------
+     * Returns the representative of the set containing element. Two elements
+     * are in the same set exactly when they have the same representative.
+     */
+    uint64_t find(uint64_t element);
+
+    /*
+     * Method: merge
+     * Usage: if (chambers.merge(one, two)) ...
+     * ----------------------------------------
+     * Joins the sets containing one and two. Returns true if they were
+     * separate sets beforehand, and false if they were already joined.
+     */
+    bool merge(uint64_t one, uint64_t two);
+
+    /*
+     * Method: size
+     * Usage: uint64_t numCells = chambers.size();
+     * -------------------------------------------
+     * Returns the number of elements in the structure.
+     */
+    uint64_t size() const;
+
+    /*
+     * Method: countSets
+     * Usage: uint64_t numChambers = chambers.countSets();
+     * ---------------------------------------------------
+     * Returns the number of distinct sets that remain.
+     */
+    uint64_t countSets() const;
+
+private:
+    std::vector<uint64_t> parent;
+    std::vector<unsigned char> rank;
+    uint64_t numSets;
+};
+
+/*
+ * Class: ConcurrentDisjointSet
+ * ----------------------------
+ * A disjoint-set structure that any number of threads can find in and merge
+ * at the same time, without locks. Every element's parent changes in a single
+ * order that all threads agree on, and each join of two sets is made by
+ * exactly one merge, so a merge returns true for exactly one of the threads
+ * that race to join the same two sets. The threads need not agree on the
+ * order of changes to different elements, though, so a thread may not yet see
+ * a join another thread has just made. The structure has the same methods as
+ * DisjointSet, plus sameSet; reset and countSets must not run while other
+ * threads are using it.
+ *
+ * Sets are joined by making the root with the lower index point to the one
+ * with the higher index, so parent pointers only ever point upward and no
+ * thread can ever close a cycle. find halves the path it walks, making every
+ * element it passes point to its grandparent.
+ */
+class ConcurrentDisjointSet {
+public:
+
+    /*
+     * Constructor: ConcurrentDisjointSet
+     * Usage: ConcurrentDisjointSet chambers(numCells);
+     * ------------------------------------------------
+     * Creates a structure holding the elements 0 through size - 1, each in
+     * its own set.
+     */
+    explicit ConcurrentDisjointSet(uint64_t size = 0);
+
+    /*
+     * Method: reset
+     * Usage: chambers.reset(numCells);
+     * --------------------------------
+     * Discards every merge and resizes the structure to hold size elements,
+     * each in its own set.
+     */
+    void reset(uint64_t size);
+
+    /*
+     * Method: find
+     * Usage: uint64_t root = chambers.find(cellIndex);
+     * ------------------------------------------------
+     * Returns an element that was the representative of element's set when
+     * find read its parent. Another thread may merge that set away before
+     * the caller looks at the result, so comparing two finds is not a safe
+     * way to tell whether two elements share a set; use sameSet for that.
+     */
+    uint64_t find(uint64_t element);
+
+    /*
+     * Method: merge
+     * Usage: if (chambers.merge(one, two)) ...
+     * ----------------------------------------
+     * Joins the sets containing one and two. Returns true if they were
+     * separate sets beforehand, and false if they were already joined.
+     */
+    bool merge(uint64_t one, uint64_t two);
+
+    /*
+     * Method: sameSet
+     * Usage: if (chambers.sameSet(one, two)) ...
+     * ------------------------------------------
+     * Returns whether one and two are in the same set. A true answer is
+     * always right, but while other threads are merging, a false answer may
+     * miss a join that has only just been made.
+     */
+    bool sameSet(uint64_t one, uint64_t two);
+
+    /*
+     * Methods: size, countSets
+     * Usage: uint64_t numChambers = chambers.countSets();
+     * ---------------------------------------------------
+     * Return the number of elements in the structure and the number of
+     * distinct sets that remain. countSets looks at every element.
+     */
+    uint64_t size() const;
+    uint64_t countSets() const;
+
+private:
+    std::vector<std::atomic<uint64_t> > parent;
+};
+
+/*
+ * Implementation notes
+ * --------------------
+ * find and merge sit on the inner loop of every generator, so they are
+ * defined here in the header where the compiler can inline them. When
+ * instrumentation is compiled in (see maze-instrumentation.h), find adds the
+ * length of the path it walked to the counters once, at the end.
+ */
+
+inline DisjointSet::DisjointSet(uint64_t size) {
+    reset(size);
+}
+
+inline void DisjointSet::reset(uint64_t size) {
+    parent.resize(size);
+    for (uint64_t i = 0; i < size; i++) {
+        parent[i] = i;
+    }
+    rank.assign(size, 0);
+    numSets = size;
+}
+
+inline uint64_t DisjointSet::find(uint64_t element) {
+    uint64_t root = element;
+#ifdef MAZE_INSTRUMENTATION
+    uint64_t steps = 0;
+    while (parent[root] != root) {
+        root = parent[root];
+        steps++;
+    }
+    MAZE_COUNT(SET_FINDS, 1);
+    MAZE_COUNT(SET_FIND_STEPS, steps);
+#else
+    while (parent[root] != root) {
+        root = parent[root];
+    }
+#endif
+    while (parent[element] != root) {
+        uint64_t next = parent[element];
+        parent[element] = root;
+        element = next;
+    }
+    return root;
+}
+
+inline bool DisjointSet::merge(uint64_t one, uint64_t two) {
+    uint64_t rootOne = find(one);
+    uint64_t rootTwo = find(two);
+    if (rootOne == rootTwo) return false;
+    if (rank[rootOne] < rank[rootTwo]) {
+        parent[rootOne] = rootTwo;
+    } else if (rank[rootOne] > rank[rootTwo]) {
+        parent[rootTwo] = rootOne;
+    } else {
+        parent[rootTwo] = rootOne;
+        rank[rootOne]++;
+    }
+    numSets--;
+    MAZE_COUNT(SET_UNIONS, 1);
+    return true;
+}
+
+inline uint64_t DisjointSet::size() const {
+    return parent.size();
+}
+
+inline uint64_t DisjointSet::countSets() const {
+    return numSets;
+}
+
+/*
+ * The parent array holds nothing but indices, and no other data is published
+ * through it, so every access can be relaxed: each element's parent still
+ * changes in a single order that every thread agrees on. A root is linked
+ * only by a compare-and-swap that expects it to still be a root, so two
+ * threads can never both link it. A failed swap in find just means another
+ * thread moved the element first, and the halving is skipped. Elements below
+ * a root always have lower indices than it, so when the lower root is linked
+ * the higher one cannot be in its set, even if the higher one has itself been
+ * linked in the meantime. As in DisjointSet, find adds the number of parent
+ * links it climbed to the instrumentation counters once it reaches a root.
+ */
+
+inline ConcurrentDisjointSet::ConcurrentDisjointSet(uint64_t size) {
+    reset(size);
+}
+
+inline void ConcurrentDisjointSet::reset(uint64_t size) {
+    if (parent.size() != size) std::vector<std::atomic<uint64_t> >(size).swap(parent);
+    for (uint64_t i = 0; i < size; i++) {
+        parent[i].store(i, std::memory_order_relaxed);
+    }
+}
+
+inline uint64_t ConcurrentDisjointSet::find(uint64_t element) {
+#ifdef MAZE_INSTRUMENTATION
+    uint64_t steps = 0;
+#endif
+    while (true) {
+        uint64_t up = parent[element].load(std::memory_order_relaxed);
+        if (up == element) {
+            MAZE_COUNT(SET_FINDS, 1);
+            MAZE_COUNT(SET_FIND_STEPS, steps);
+            return element;
+        }
+        uint64_t grandparent = parent[up].load(std::memory_order_relaxed);
+        if (grandparent != up) {
+            parent[element].compare_exchange_weak(up, grandparent, std::memory_order_relaxed);
+        }
+        element = grandparent;
+#ifdef MAZE_INSTRUMENTATION
+        steps += grandparent != up ? 2 : 1;
+#endif
+    }
+}
+
+inline bool ConcurrentDisjointSet::merge(uint64_t one, uint64_t two) {
+    while (true) {
+        one = find(one);
+        two = find(two);
+        if (one == two) return false;
+        if (one > two) std::swap(one, two);
+        uint64_t expected = one;
+        if (parent[one].compare_exchange_strong(expected, two, std::memory_order_relaxed)) {
+            MAZE_COUNT(SET_UNIONS, 1);
+            return true;
+        }
+    }
+}
+
+/*
+ * If one's root still reads as a root after two's root was found, the two
+ * elements were in different sets as far as this thread can see. Elements
+ * never leave a set once they join it, so equal roots always mean one set.
+ */
+inline bool ConcurrentDisjointSet::sameSet(uint64_t one, uint64_t two) {
+    while (true) {
+        one = find(one);
+        two = find(two);
+        if (one == two) return true;
+        if (parent[one].load(std::memory_order_relaxed) == one) return false;
+    }
+}
+
+inline uint64_t ConcurrentDisjointSet::size() const {
+    return parent.size();
+}
+
+inline uint64_t ConcurrentDisjointSet::countSets() const {
+    uint64_t numSets = 0;
+    for (uint64_t i = 0; i < parent.size(); i++) {
+        if (parent[i].load(std::memory_order_relaxed) == i) numSets++;
+    }
+    return numSets;
+}
+
+#endif
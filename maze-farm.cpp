@@ -0,0 +1,353 @@
+/**
+ * File: maze-farm.cpp
+ * -------------------
+ * Implements the maze farm and archive reader declared in maze-farm.h.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+#include "maze-farm.h"
+#include "maze-file.h"
+#include "maze-metrics.h"
+#include "maze-random.h"
+
+/*
+ * Type: farmWorker
+ * ----------------
+ * Everything one thread of the farm owns. The maze numbers nextMaze up to (but not including) endMaze are still waiting to be
+ * farmed; the thread takes them from the front, and other threads steal from the back, always under queueLock. The maze,
+ * scratch and buffer are reused from one maze to the next. buffer holds the walls of accepted mazes not yet written to the
+ * archive, which are described by the entries from firstUnwritten on, with offsets counted from the start of the buffer.
+ */
+struct farmWorker {
+    mutex queueLock;
+    uint64_t nextMaze;
+    uint64_t endMaze;
+    MazeBitplanes maze;
+    kruskalScratch scratch;
+    vector<uint64_t> buffer;
+    vector<farmIndexEntry> entries;
+    size_t firstUnwritten;
+    uint64_t generated;
+    uint64_t stolenBatches;
+    double generateSeconds;
+    double measureSeconds;
+    double packSeconds;
+    double writeSeconds;
+};
+
+/*
+ * Type: farmArchiveFile
+ * ---------------------
+ * The archive being written, shared by every thread. fileEnd is the offset at which the next buffer will be written.
+ */
+struct farmArchiveFile {
+    mutex lock;
+    ofstream file;
+    uint64_t fileEnd;
+};
+
+//Prototypes
+static void runFarmWorker(const farmOptions & options, vector<farmWorker> & workers, size_t self, farmArchiveFile & archive,
+                          atomic<uint64_t> & mazesDone, MazeProgressFn progress);
+static bool takeMaze(vector<farmWorker> & workers, size_t self, uint64_t & mazeNumber);
+static bool stealMazes(vector<farmWorker> & workers, size_t self);
+static void farmMaze(const farmOptions & options, farmWorker & worker, uint64_t mazeNumber, farmArchiveFile & archive);
+static void writeBuffer(farmWorker & worker, farmArchiveFile & archive);
+static uint64_t pickDimension(uint64_t random, uint64_t minimum, uint64_t maximum);
+static double secondsSince(chrono::steady_clock::time_point start);
+static bool isEntryInBounds(const farmIndexEntry & entry, uint64_t indexOffset);
+static const char farmArchiveMagic[8] = { 'M', 'A', 'Z', 'E', 'F', 'A', 'R', 'M' };
+static const uint64_t farmSizeSalt = 0x73697a6573ULL;
+static const size_t farmBufferWords = 1 << 19;
+static const uint64_t progressSteps = 100;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "farm archives are in memory order and must be little-endian");
+
+/*
+ * The archive is opened with a provisional header, and the calling thread works alongside the others as worker 0. Once every
+ * thread has finished and written what was left in its buffer, the entries are gathered, sorted by maze number and written as
+ * the index, and the header is filled in.
+ */
+bool runMazeFarm(const farmOptions & options, const string & filename, farmReport & report, MazeProgressFn progress) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    memset(&report, 0, sizeof(report));
+    farmArchiveFile archive;
+    archive.file.open(filename.c_str(), ios::binary | ios::trunc);
+    if (!archive.file.is_open()) return false;
+    farmArchiveHeader header;
+    memcpy(header.magic, farmArchiveMagic, sizeof(header.magic));
+    header.numMazes = 0;
+    header.indexOffset = 0;
+    header.seed = options.seed;
+    archive.file.write((const char *) &header, sizeof(header));
+    archive.fileEnd = sizeof(header);
+
+    size_t numWorkers = options.numThreads < 1 ? 1 : options.numThreads;
+    vector<farmWorker> workers(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+        workers[i].nextMaze = options.count * i / numWorkers;
+        workers[i].endMaze = options.count * (i + 1) / numWorkers;
+        workers[i].firstUnwritten = 0;
+        workers[i].generated = 0;
+        workers[i].stolenBatches = 0;
+        workers[i].generateSeconds = 0;
+        workers[i].measureSeconds = 0;
+        workers[i].packSeconds = 0;
+        workers[i].writeSeconds = 0;
+    }
+    atomic<uint64_t> mazesDone(0);
+    vector<thread> threads;
+    for (size_t i = 1; i < numWorkers; i++) {
+        threads.push_back(thread(runFarmWorker, cref(options), ref(workers), i, ref(archive), ref(mazesDone),
+                                 (MazeProgressFn) NULL));
+    }
+    runFarmWorker(options, workers, 0, archive, mazesDone, progress);
+    for (thread & worker : threads) {
+        worker.join();
+    }
+    if (progress != NULL) progress("Farming mazes", 1);
+
+    vector<farmIndexEntry> index;
+    for (const farmWorker & worker : workers) {
+        index.insert(index.end(), worker.entries.begin(), worker.entries.end());
+        report.generated += worker.generated;
+        report.stolenBatches += worker.stolenBatches;
+        report.generateSeconds += worker.generateSeconds;
+        report.measureSeconds += worker.measureSeconds;
+        report.packSeconds += worker.packSeconds;
+        report.writeSeconds += worker.writeSeconds;
+    }
+    sort(index.begin(), index.end(), [](const farmIndexEntry & one, const farmIndexEntry & two) {
+        return one.mazeNumber < two.mazeNumber;
+    });
+    header.numMazes = index.size();
+    header.indexOffset = archive.fileEnd;
+    if (!index.empty()) archive.file.write((const char *) index.data(), index.size() * sizeof(farmIndexEntry));
+    archive.file.seekp(0);
+    archive.file.write((const char *) &header, sizeof(header));
+    bool succeeded = !archive.file.fail();
+    archive.file.close();
+    report.accepted = index.size();
+    report.archiveBytes = header.indexOffset + index.size() * sizeof(farmIndexEntry);
+    report.totalSeconds = secondsSince(start);
+    return succeeded && !archive.file.fail();
+}
+
+/*
+ * The header and the whole index are read and checked against each other before any maze is loaded, and every entry is
+ * checked to lie between the header and the index (see isEntryInBounds), so that loadMaze never sizes a maze from a damaged
+ * entry and only has to check the walls it reads.
+ */
+bool MazeFarmArchive::open(const string & filename) {
+    if (file.is_open()) file.close();
+    file.clear();
+    entries.clear();
+    file.open(filename.c_str(), ios::binary);
+    farmArchiveHeader header;
+    file.read((char *) &header, sizeof(header));
+    if (file.fail() || memcmp(header.magic, farmArchiveMagic, sizeof(header.magic)) != 0) return false;
+    file.seekg(0, ios::end);
+    uint64_t fileSize = file.tellg();
+    if (header.indexOffset > fileSize || (fileSize - header.indexOffset) / sizeof(farmIndexEntry) != header.numMazes) {
+        return false;
+    }
+    entries.resize(header.numMazes);
+    file.seekg(header.indexOffset);
+    if (!entries.empty()) file.read((char *) entries.data(), entries.size() * sizeof(farmIndexEntry));
+    bool succeeded = !file.fail();
+    for (uint64_t i = 0; i < entries.size() && succeeded; i++) {
+        succeeded = isEntryInBounds(entries[i], header.indexOffset);
+    }
+    if (!succeeded) entries.clear();
+    return succeeded;
+}
+
+uint64_t MazeFarmArchive::numMazes() const {
+    return entries.size();
+}
+
+const farmIndexEntry & MazeFarmArchive::entry(uint64_t i) const {
+    return entries[i];
+}
+
+bool MazeFarmArchive::loadMaze(uint64_t i, MazeBitplanes & maze) {
+    const farmIndexEntry & wanted = entries[i];
+    maze.resize(wanted.width, wanted.height);
+    uint64_t numWords = maze.memoryUsage() / sizeof(uint64_t);
+    file.clear();
+    file.seekg(wanted.offset);
+    file.read((char *) maze.eastRow(0), numWords * sizeof(uint64_t));
+    if (file.fail()) return false;
+    return mazeChecksum(0, maze.eastRow(0), numWords) == wanted.checksum;
+}
+
+/*
+ * This method farms mazes on one thread until there are none left to take, then writes whatever is still in its buffer. Only
+ * the thread given a progress function reports progress, counting the mazes every thread has finished, a hundredth of the way
+ * at a time. Completion is reported by runMazeFarm once every thread is done.
+ */
+static void runFarmWorker(const farmOptions & options, vector<farmWorker> & workers, size_t self, farmArchiveFile & archive,
+                          atomic<uint64_t> & mazesDone, MazeProgressFn progress) {
+    farmWorker & worker = workers[self];
+    uint64_t mazeNumber;
+    uint64_t stepsReported = 0;
+    while (takeMaze(workers, self, mazeNumber)) {
+        farmMaze(options, worker, mazeNumber, archive);
+        uint64_t steps = ++mazesDone * progressSteps / options.count;
+        if (progress != NULL && steps > stepsReported && steps < progressSteps) {
+            progress("Farming mazes", (double) steps / progressSteps);
+            stepsReported = steps;
+        }
+    }
+    writeBuffer(worker, archive);
+}
+
+/*
+ * This method takes the next maze number from the thread's own share, stealing more when the share runs out. Returns false
+ * once there is nothing left anywhere.
+ */
+static bool takeMaze(vector<farmWorker> & workers, size_t self, uint64_t & mazeNumber) {
+    farmWorker & worker = workers[self];
+    while (true) {
+        {
+            lock_guard<mutex> lock(worker.queueLock);
+            if (worker.nextMaze < worker.endMaze) {
+                mazeNumber = worker.nextMaze++;
+                return true;
+            }
+        }
+        if (!stealMazes(workers, self)) return false;
+    }
+}
+
+/*
+ * This method finds the thread with the most maze numbers left and moves the second half of them to the given thread. Only
+ * one lock is held at a time, so two threads stealing from each other can never deadlock. The numbers are out of every queue
+ * between the two locks, so another thread may briefly see nothing left and finish early; the numbers are still farmed by the
+ * thread that stole them. Returns false if every other thread has run out.
+ */
+static bool stealMazes(vector<farmWorker> & workers, size_t self) {
+    size_t victim = self;
+    uint64_t mostLeft = 0;
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (i == self) continue;
+        lock_guard<mutex> lock(workers[i].queueLock);
+        uint64_t left = workers[i].endMaze - workers[i].nextMaze;
+        if (left > mostLeft) {
+            mostLeft = left;
+            victim = i;
+        }
+    }
+    if (victim == self) return false;
+    uint64_t first;
+    uint64_t end;
+    {
+        lock_guard<mutex> lock(workers[victim].queueLock);
+        uint64_t left = workers[victim].endMaze - workers[victim].nextMaze;
+        if (left == 0) return true;
+        end = workers[victim].endMaze;
+        first = end - (left + 1) / 2;
+        workers[victim].endMaze = first;
+    }
+    lock_guard<mutex> lock(workers[self].queueLock);
+    workers[self].nextMaze = first;
+    workers[self].endMaze = end;
+    workers[self].stolenBatches++;
+    return true;
+}
+
+/*
+ * This method generates and measures one maze and, if it is accepted, packs its walls and an entry describing it into the
+ * thread's buffer, writing the buffer out first if the maze would not fit.
+ */
+static void farmMaze(const farmOptions & options, farmWorker & worker, uint64_t mazeNumber, farmArchiveFile & archive) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t seed = counterRandom(options.seed, mazeNumber);
+    uint64_t size = counterRandom(options.seed ^ farmSizeSalt, mazeNumber);
+    uint64_t width = pickDimension(size & 0xffffffff, options.minWidth, options.maxWidth);
+    uint64_t height = pickDimension(size >> 32, options.minHeight, options.maxHeight);
+    worker.maze.resize(width, height);
+    uint64_t wallsExamined;
+    generateKruskalMaze(worker.maze, seed, wallsExamined, NULL, worker.scratch, ROW_MAJOR_LAYOUT);
+    worker.generated++;
+    worker.generateSeconds += secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    mazeMetrics metrics = measureMaze(worker.maze, 1);
+    worker.measureSeconds += secondsSince(start);
+    if (!metrics.solvable || metrics.solutionLength < options.minSolutionRatio * (width + height - 2)) return;
+
+    uint64_t numWords = worker.maze.memoryUsage() / sizeof(uint64_t);
+    if (!worker.buffer.empty() && worker.buffer.size() + numWords > farmBufferWords) writeBuffer(worker, archive);
+    start = chrono::steady_clock::now();
+    const uint64_t *words = worker.maze.eastRow(0);
+    farmIndexEntry entry;
+    entry.mazeNumber = mazeNumber;
+    entry.seed = seed;
+    entry.width = width;
+    entry.height = height;
+    entry.offset = worker.buffer.size() * sizeof(uint64_t);
+    entry.deadEnds = metrics.deadEnds;
+    entry.junctions = metrics.junctions;
+    entry.diameter = metrics.diameter;
+    entry.solutionLength = metrics.solutionLength;
+    entry.solutionTurns = metrics.solutionTurns;
+    entry.checksum = mazeChecksum(0, words, numWords);
+    worker.buffer.insert(worker.buffer.end(), words, words + numWords);
+    worker.entries.push_back(entry);
+    worker.packSeconds += secondsSince(start);
+}
+
+/*
+ * This method appends the thread's buffer to the archive, turns the offsets of the entries it holds into offsets within the
+ * file, and empties the buffer, keeping its memory for the next mazes.
+ */
+static void writeBuffer(farmWorker & worker, farmArchiveFile & archive) {
+    if (worker.buffer.empty()) return;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t base;
+    {
+        lock_guard<mutex> lock(archive.lock);
+        base = archive.fileEnd;
+        archive.file.write((const char *) worker.buffer.data(), worker.buffer.size() * sizeof(uint64_t));
+        archive.fileEnd += worker.buffer.size() * sizeof(uint64_t);
+    }
+    for (size_t i = worker.firstUnwritten; i < worker.entries.size(); i++) {
+        worker.entries[i].offset += base;
+    }
+    worker.firstUnwritten = worker.entries.size();
+    worker.buffer.clear();
+    worker.writeSeconds += secondsSince(start);
+}
+
+/*
+ * This method spreads a 32-bit random number evenly over the dimensions minimum through maximum, inclusive.
+ */
+static uint64_t pickDimension(uint64_t random, uint64_t minimum, uint64_t maximum) {
+    return minimum + ((random * (maximum - minimum + 1)) >> 32);
+}
+
+/*
+ * This method returns how many seconds have passed since start.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * This method returns whether the walls an index entry describes lie after the header and end by the start of the index.
+ * The number of rows that fit is found by dividing, and the number of words per row is rounded up without adding to the
+ * width, so no damaged width or height can overflow the sum.
+ */
+static bool isEntryInBounds(const farmIndexEntry & entry, uint64_t indexOffset) {
+    if (entry.offset < sizeof(farmArchiveHeader) || entry.offset > indexOffset) return false;
+    uint64_t wordsPerRow = entry.width / 64 + (entry.width % 64 != 0);
+    if (wordsPerRow == 0) return true;
+    return entry.height <= (indexOffset - entry.offset) / (2 * wordsPerRow * sizeof(uint64_t));
+}
@@ -0,0 +1,167 @@
+/**
+ * File: maze-farm.h
+ * -----------------
+ * Declares a batch "farm" that generates and measures many mazes at once on
+ * a pool of threads, and writes the ones worth keeping into a single indexed
+ * archive, along with a reader for such archives.
+ *
+ * A farm archive is a 32-byte farmArchiveHeader, followed by the walls of
+ * every accepted maze in the layout used by MazeBitplanes, one maze after
+ * another in no particular order, and then an index of one farmIndexEntry per
+ * accepted maze, sorted by maze number. Values are written just as they sit
+ * in memory, so, like maze files, archives are only built on little-endian
+ * machines, where they are little-endian.
+ */
+
+#ifndef _maze_farm_
+#define _maze_farm_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "maze-bitplanes.h"
+#include "maze-headless.h"
+
+/*
+ * Type: farmOptions
+ * -----------------
+ * What a farm should produce. Mazes are numbered from 0 to count - 1, and
+ * maze n is a Kruskal maze whose width, height and seed are all drawn from
+ * counterRandom(seed, n) (see maze-random.h), with the width and height
+ * spread evenly over the given ranges. A maze is accepted when its solution
+ * (see mazeMetrics) is at least minSolutionRatio times as long as the
+ * shortest possible path from its top-left cell to its bottom-right cell; a
+ * ratio of 0 accepts every maze.
+ */
+struct farmOptions {
+    uint64_t count;
+    uint64_t minWidth;
+    uint64_t maxWidth;
+    uint64_t minHeight;
+    uint64_t maxHeight;
+    uint64_t seed;
+    double minSolutionRatio;
+    int numThreads;
+};
+
+/*
+ * Type: farmReport
+ * ----------------
+ * What a farm did. The seconds spent generating, measuring, packing accepted
+ * mazes into a thread's buffer, and writing buffers to the archive are summed
+ * over every thread, so together they can exceed totalSeconds, which is the
+ * time the whole farm took. stolenBatches counts the times a thread ran out
+ * of mazes and took half of another thread's.
+ */
+struct farmReport {
+    uint64_t generated;
+    uint64_t accepted;
+    uint64_t archiveBytes;
+    uint64_t stolenBatches;
+    double totalSeconds;
+    double generateSeconds;
+    double measureSeconds;
+    double packSeconds;
+    double writeSeconds;
+};
+
+/*
+ * Type: farmArchiveHeader
+ * -----------------------
+ * The first 32 bytes of every farm archive. indexOffset is where the index
+ * starts, counted in bytes from the start of the file.
+ */
+struct farmArchiveHeader {
+    char magic[8];
+    uint64_t numMazes;
+    uint64_t indexOffset;
+    uint64_t seed;
+};
+
+/*
+ * Type: farmIndexEntry
+ * --------------------
+ * Describes one accepted maze: its number and seed, its size, where its walls
+ * start in the archive, what measureMaze found, and the checksum of its walls
+ * (see mazeChecksum in maze-file.h).
+ */
+struct farmIndexEntry {
+    uint64_t mazeNumber;
+    uint64_t seed;
+    uint64_t width;
+    uint64_t height;
+    uint64_t offset;
+    uint64_t deadEnds;
+    uint64_t junctions;
+    uint64_t diameter;
+    uint64_t solutionLength;
+    uint64_t solutionTurns;
+    uint64_t checksum;
+};
+
+/*
+ * Function: runMazeFarm
+ * Usage: if (runMazeFarm(options, filename, report, reportProgress)) ...
+ * ----------------------------------------------------------------------
+ * Generates and measures options.count mazes on options.numThreads threads
+ * and writes the accepted ones to a farm archive. Every maze depends only on
+ * the seed and its own number, so the same options always accept the same
+ * mazes with the same walls, however many threads there are; only the order
+ * of the mazes in the archive changes. Returns false if the archive could not
+ * be written.
+ *
+ * Each thread starts with an equal share of the maze numbers and takes them
+ * one at a time. A thread that runs out takes the second half of whatever
+ * remains to the thread with the most left, so threads that drew small mazes
+ * help out the ones that drew large ones. Each thread reuses its own maze,
+ * Kruskal scratch (see maze-headless.h) and output buffer from one maze to
+ * the next, and only takes the lock on the archive when its buffer is full.
+ * progress, if not NULL, is called from the calling thread alone.
+ */
+bool runMazeFarm(const farmOptions & options, const std::string & filename, farmReport & report,
+                 MazeProgressFn progress);
+
+/*
+ * Class: MazeFarmArchive
+ * ----------------------
+ * Reads the index of a farm archive and loads the mazes in it one at a time.
+ */
+class MazeFarmArchive {
+public:
+
+    /*
+     * Method: open
+     * Usage: if (archive.open(filename)) ...
+     * --------------------------------------
+     * Opens a farm archive and reads its index, replacing any archive opened
+     * before. Returns false if the file cannot be read, is not a farm
+     * archive, or has an index entry for walls outside the archive.
+     */
+    bool open(const std::string & filename);
+
+    /*
+     * Methods: numMazes, entry
+     * Usage: const farmIndexEntry & entry = archive.entry(i);
+     * -------------------------------------------------------
+     * Return the number of mazes in the archive and the index entry of the
+     * ith, counting in order of maze number.
+     */
+    uint64_t numMazes() const;
+    const farmIndexEntry & entry(uint64_t i) const;
+
+    /*
+     * Method: loadMaze
+     * Usage: if (archive.loadMaze(i, maze)) ...
+     * -----------------------------------------
+     * Reads the walls of the ith maze into maze. Returns false if they cannot
+     * be read or do not match the checksum in the index.
+     */
+    bool loadMaze(uint64_t i, MazeBitplanes & maze);
+
+private:
+    std::ifstream file;
+    std::vector<farmIndexEntry> entries;
+};
+
+#endif
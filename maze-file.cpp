@@ -0,0 +1,167 @@
+/**
+ * File: maze-file.cpp
+ * -------------------
+ * Implements reading and writing maze files.
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include "maze-file.h"
+
+//Prototypes
+static void fillHeader(mazeFileHeader & header, uint64_t width, uint64_t seed, MazeAlgorithm algorithm);
+static const char mazeFileMagic[8] = { 'M', 'A', 'Z', 'E', 'B', 'I', 'T', 'S' };
+static const uint32_t mazeFileVersion = 1;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "maze files are in memory order and must be little-endian");
+
+/*
+ * Each word is mixed into the running value with a multiply and a shift, so that flipped, swapped or missing words all change
+ * the result, while the whole maze still streams through at memory speed.
+ */
+uint64_t mazeChecksum(uint64_t checksum, const uint64_t *words, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        checksum = (checksum ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+        checksum ^= checksum >> 29;
+    }
+    return checksum;
+}
+
+MazeFileWriter::MazeFileWriter() {
+    memset(&header, 0, sizeof(header));
+}
+
+MazeFileWriter::~MazeFileWriter() {
+    if (file.is_open()) close();
+}
+
+bool MazeFileWriter::open(const string & filename, uint64_t width, uint64_t seed, MazeAlgorithm algorithm) {
+    if (file.is_open()) close();
+    fillHeader(header, width, seed, algorithm);
+    file.open(filename.c_str(), ios::binary | ios::trunc);
+    if (file.fail()) return false;
+    file.write((const char *) &header, sizeof(header));
+    return !file.fail();
+}
+
+void MazeFileWriter::writeRow(const uint64_t *eastWords, const uint64_t *southWords) {
+    uint64_t rowBytes = header.wordsPerRow * sizeof(uint64_t);
+    file.write((const char *) eastWords, rowBytes);
+    file.write((const char *) southWords, rowBytes);
+    header.checksum = mazeChecksum(header.checksum, eastWords, header.wordsPerRow);
+    header.checksum = mazeChecksum(header.checksum, southWords, header.wordsPerRow);
+    header.height++;
+}
+
+bool MazeFileWriter::acceptRow(uint64_t, const uint64_t *eastWords, const uint64_t *southWords) {
+    writeRow(eastWords, southWords);
+    return !file.fail();
+}
+
+/*
+ * The header written by open was missing the height and the checksum, which are only known once every row has been written,
+ * so it is written again over the start of the file.
+ */
+bool MazeFileWriter::close() {
+    file.seekp(0);
+    file.write((const char *) &header, sizeof(header));
+    bool succeeded = !file.fail();
+    file.close();
+    return succeeded && !file.fail();
+}
+
+bool saveMaze(const MazeBitplanes & maze, const string & filename, uint64_t seed, MazeAlgorithm algorithm) {
+    MazeFileWriter writer;
+    if (!writer.open(filename, maze.width(), seed, algorithm)) return false;
+    for (uint64_t row = 0; row < maze.height(); row++) {
+        writer.writeRow(maze.eastRow(row), maze.southRow(row));
+    }
+    return writer.close();
+}
+
+MappedMazeFile::MappedMazeFile() {
+    mapping = NULL;
+    mappingSize = 0;
+    memset(&fileHeader, 0, sizeof(fileHeader));
+}
+
+MappedMazeFile::~MappedMazeFile() {
+    close();
+}
+
+/*
+ * The whole file, header included, is mapped with one call to mmap. The header is checked against the size of the file
+ * before the maze is attached to the rows that follow it, so a truncated file is rejected rather than read past its end. The
+ * height is compared with the number of rows that fit in the file before it is multiplied by the size of a row, so a header
+ * with an enormous height cannot wrap the product around to the size of the file.
+ */
+bool MappedMazeFile::open(const string & filename) {
+    close();
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) return false;
+    struct stat fileStats;
+    if (fstat(descriptor, &fileStats) != 0 || (uint64_t) fileStats.st_size < sizeof(mazeFileHeader)) {
+        ::close(descriptor);
+        return false;
+    }
+    mappingSize = fileStats.st_size;
+    mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (mapping == MAP_FAILED) {
+        mapping = NULL;
+        return false;
+    }
+    memcpy(&fileHeader, mapping, sizeof(fileHeader));
+    uint64_t rowsSize = mappingSize - sizeof(mazeFileHeader);
+    if (memcmp(fileHeader.magic, mazeFileMagic, sizeof(mazeFileMagic)) != 0
+            || fileHeader.version != mazeFileVersion
+            || fileHeader.wordsPerRow == 0
+            || fileHeader.wordsPerRow != (fileHeader.width + 63) / 64
+            || fileHeader.height > rowsSize / (2 * fileHeader.wordsPerRow * sizeof(uint64_t))
+            || 2 * fileHeader.wordsPerRow * fileHeader.height * sizeof(uint64_t) != rowsSize) {
+        close();
+        return false;
+    }
+    mappedMaze.attach((uint64_t *) ((char *) mapping + sizeof(mazeFileHeader)), fileHeader.width, fileHeader.height);
+    return true;
+}
+
+void MappedMazeFile::close() {
+    if (mapping != NULL) munmap(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    mappedMaze.resize(0, 0);
+}
+
+bool MappedMazeFile::verifyChecksum() const {
+    uint64_t checksum = 0;
+    for (uint64_t row = 0; row < mappedMaze.height(); row++) {
+        checksum = mazeChecksum(checksum, mappedMaze.eastRow(row), 2 * fileHeader.wordsPerRow);
+    }
+    return checksum == fileHeader.checksum;
+}
+
+const mazeFileHeader & MappedMazeFile::header() const {
+    return fileHeader;
+}
+
+MazeBitplanes & MappedMazeFile::maze() {
+    return mappedMaze;
+}
+
+/*
+ * This method fills in every field of a header that is known before the first row is written.
+ */
+static void fillHeader(mazeFileHeader & header, uint64_t width, uint64_t seed, MazeAlgorithm algorithm) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, mazeFileMagic, sizeof(mazeFileMagic));
+    header.version = mazeFileVersion;
+    header.algorithm = algorithm;
+    header.width = width;
+    header.seed = seed;
+    header.wordsPerRow = (width + 63) / 64;
+}
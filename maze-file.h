@@ -0,0 +1,186 @@
+/**
+ * File: maze-file.h
+ * -----------------
+ * Defines the binary file format for saving mazes, along with a writer that
+ * streams a maze to disk a row at a time and a reader that maps a saved maze
+ * straight into memory.
+ *
+ * A maze file is a 64-byte mazeFileHeader followed by the rows of the maze in
+ * the layout used by MazeBitplanes: for each row, wordsPerRow 64-bit words of
+ * east walls and then wordsPerRow words of south walls. Values are written
+ * just as they sit in memory, with no byte swapping, so maze-file.cpp only
+ * compiles on little-endian machines, and every maze file is little-endian.
+ * A 100,000 x 100,000 maze takes about 2.5 GB.
+ */
+
+#ifndef _maze_file_
+#define _maze_file_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "maze-bitplanes.h"
+
+/*
+ * Type: MazeAlgorithm
+ * -------------------
+ * Records which generator produced a saved maze.
+ */
+enum MazeAlgorithm {
+    KRUSKAL_ALGORITHM = 1,
+    PARALLEL_KRUSKAL_ALGORITHM = 2,
+    ELLER_ALGORITHM = 3,
+    WILSON_ALGORITHM = 4,
+    CORRIDOR_KRUSKAL_ALGORITHM = 5,
+    NOISE_KRUSKAL_ALGORITHM = 6,
+    BACKTRACKER_ALGORITHM = 7,
+    HUNT_AND_KILL_ALGORITHM = 8
+};
+
+/*
+ * Type: mazeFileHeader
+ * --------------------
+ * The first 64 bytes of every maze file. The checksum covers every word of
+ * the rows that follow the header (see mazeChecksum).
+ */
+struct mazeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t algorithm;
+    uint64_t width;
+    uint64_t height;
+    uint64_t seed;
+    uint64_t wordsPerRow;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+/*
+ * Function: mazeChecksum
+ * Usage: checksum = mazeChecksum(checksum, words, count);
+ * -------------------------------------------------------
+ * Folds count words into a running checksum and returns the result. Start
+ * from 0 and feed the rows in order; the checksum of the whole maze does not
+ * depend on how the rows are split between calls.
+ */
+uint64_t mazeChecksum(uint64_t checksum, const uint64_t *words, uint64_t count);
+
+/*
+ * Class: MazeFileWriter
+ * ---------------------
+ * Writes a maze file one row at a time, so a generator can hand each row over
+ * as soon as it is final and never needs the whole maze in memory. The height
+ * and checksum are filled into the header when the writer is closed. As a
+ * MazeRowSink, a writer can be handed straight to a streaming generator.
+ */
+class MazeFileWriter : public MazeRowSink {
+public:
+    MazeFileWriter();
+    ~MazeFileWriter();
+
+    /*
+     * Method: open
+     * Usage: if (writer.open(filename, width, seed, KRUSKAL_ALGORITHM)) ...
+     * ---------------------------------------------------------------------
+     * Creates the file and writes a provisional header. Returns false if the
+     * file cannot be created.
+     */
+    bool open(const std::string & filename, uint64_t width, uint64_t seed, MazeAlgorithm algorithm);
+
+    /*
+     * Method: writeRow
+     * Usage: writer.writeRow(maze.eastRow(row), maze.southRow(row));
+     * --------------------------------------------------------------
+     * Appends the next row of the maze, given its east and south words.
+     */
+    void writeRow(const uint64_t *eastWords, const uint64_t *southWords);
+
+    /*
+     * Method: acceptRow
+     * Usage: generateEllerMaze(width, height, seed, writer, NULL);
+     * ------------------------------------------------------------
+     * Writes the row as writeRow does. Returns false once writing fails.
+     */
+    bool acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords);
+
+    /*
+     * Method: close
+     * Usage: if (writer.close()) ...
+     * ------------------------------
+     * Completes the header and closes the file. Returns false if anything
+     * written since open failed to reach the disk.
+     */
+    bool close();
+
+private:
+    std::ofstream file;
+    mazeFileHeader header;
+};
+
+/*
+ * Function: saveMaze
+ * Usage: if (saveMaze(maze, filename, seed, KRUSKAL_ALGORITHM)) ...
+ * -----------------------------------------------------------------
+ * Writes a maze that is already in memory to a maze file. Returns false if
+ * the file could not be written.
+ */
+bool saveMaze(const MazeBitplanes & maze, const std::string & filename, uint64_t seed, MazeAlgorithm algorithm);
+
+/*
+ * Class: MappedMazeFile
+ * ---------------------
+ * Loads a maze file with a single call to mmap and exposes it as a
+ * MazeBitplanes that reads the mapped pages directly. Pages are mapped
+ * privately, so changing the maze never changes the file.
+ */
+class MappedMazeFile {
+public:
+    MappedMazeFile();
+    ~MappedMazeFile();
+
+    /*
+     * Method: open
+     * Usage: if (mapped.open(filename)) ...
+     * -------------------------------------
+     * Maps a maze file, replacing any file mapped before. Returns false if
+     * the file cannot be read, is not a maze file, or is the wrong size.
+     */
+    bool open(const std::string & filename);
+
+    /*
+     * Method: close
+     * Usage: mapped.close();
+     * ----------------------
+     * Unmaps the file. The destructor does this automatically.
+     */
+    void close();
+
+    /*
+     * Method: verifyChecksum
+     * Usage: if (!mapped.verifyChecksum()) ...
+     * ----------------------------------------
+     * Reads every row of the maze and returns whether the checksum matches
+     * the one stored in the header.
+     */
+    bool verifyChecksum() const;
+
+    /*
+     * Methods: header, maze
+     * Usage: MazeBitplanes & maze = mapped.maze();
+     * --------------------------------------------
+     * Return the header and the walls of the mapped maze.
+     */
+    const mazeFileHeader & header() const;
+    MazeBitplanes & maze();
+
+private:
+    void *mapping;
+    uint64_t mappingSize;
+    mazeFileHeader fileHeader;
+    MazeBitplanes mappedMaze;
+
+    MappedMazeFile(const MappedMazeFile & src);
+    MappedMazeFile & operator=(const MappedMazeFile & src);
+};
+
+#endif
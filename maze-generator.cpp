@@ -4,52 +4,204 @@
  * Presents an adaptation of Kruskal's algorithm to generate mazes.
  */
 
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <new>
+#include <thread>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 #include "console.h"
+#include "gwindow.h"
 #include "random.h"
 #include "simpio.h"
+#include "strlib.h"
 #include "maze-graphics.h"
 #include "maze-types.h"
-#include "set.h"
+#include "maze-disjoint-set.h"
+#include "maze-random.h"
+#include "maze-bitplanes.h"
+#include "maze-headless.h"
+#include "maze-file.h"
+#include "maze-solver.h"
+#include "maze-metrics.h"
+#include "maze-braid.h"
+#include "maze-image.h"
+#include "maze-replay.h"
+#include "maze-graph.h"
+#include "maze-farm.h"
+#include "maze-chunks.h"
+#include "maze-instrumentation.h"
 #include "vector.h"
 
+/*
+ * Class: ConsoleRowSink
+ * ---------------------
+ * Displays a streamed maze on the console as it is generated, drawing each row with '|' for east walls and "--" for south walls
+ * as soon as the row arrives. Only used for mazes narrow enough to fit on a line.
+ */
+class ConsoleRowSink : public MazeRowSink {
+public:
+    explicit ConsoleRowSink(uint64_t width);
+    bool acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords);
+
+private:
+    uint64_t mazeWidth;
+};
+
+/*
+ * Class: CacheMissCounter
+ * -----------------------
+ * Counts the cache misses this thread causes between start and stop, using the processor's own counters through
+ * perf_event_open. Only available on Linux, and only where the kernel lets programs read the counters; stop returns -1 when
+ * the count is not available.
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter();
+    ~CacheMissCounter();
+    void start();
+    int64_t stop();
+
+private:
+    int descriptor;
+};
+
 //Prototypes
+static int getGenerationMode();
+static void generateAnimatedMaze();
+static void generateHeadlessMaze();
+static void inspectMazeFile();
+static void streamEllerMaze();
+static void benchmarkGenerators();
+static void exploreInfiniteMaze();
+static void replayAnimatedMaze();
+static void carveGraphMaze();
+static void farmMazeBatch();
+static void testConcurrentDisjointSet();
+static bool stressConcurrentSet(int numThreads, uint64_t numElements, uint64_t pairsPerThread, uint64_t seed);
+#ifdef MAZE_INSTRUMENTATION
+static void reportInstrumentation();
+#endif
+static void printBenchmarkLine(string name, double seconds, uint64_t numCells, uint64_t memoryNeeded);
+static void compareCellLayouts(uint64_t width, uint64_t height, uint64_t seed);
+static void printLayoutLine(string name, double seconds, int64_t cacheMisses);
 static int getMazeDimension(string prompt);
-static Vector<wall> initializeWallsAndChambers(int initialDimensions, Set<cell> & initialCellList, MazeGeneratorView & mazeWindow);
-static void initializeCellWalls(int cellX, int cellY, Vector<wall> & originalWallVector, int originalDimensions, MazeGeneratorView & originalWindow);
-static Vector<wall> shuffleWalls(Vector<wall> unshuffledWallVector);
-static void removeSeparatingWalls(Vector<wall> wallOrder, MazeGeneratorView & finalWindow, Set<cell> & uneliminatedCells);
-static void createNewMergedCell(Vector<Set <cell> > & origMergedCells, Set<cell> & origUnmergedCells, cell unmergedOne, cell unmergedTwo);
-static void addToMergedCell(Vector<Set <cell> > & origMergedCells, Set<cell> & origUnmergedCells, cell mergedCell, cell unmergedCell);
-static void combineTwoMergedCells(Vector<Set <cell> > & origMergedCells, cell mergedOne, cell mergedTwo);
+static void getAnimationSpeed(int & framesPerSecond, int & wallsPerFrame);
+static int getHeadlessDimension(string prompt);
+static int getHeadlessThreads(string prompt);
+static int getFarmDimension(string prompt, int minimum);
+static uint64_t getSeed(string prompt);
+static int getHeadlessAlgorithm();
+static int getWallWeights();
+static int getGraphShape();
+static void makeDiscMask(uint64_t width, uint64_t height, vector<bool> & mask);
+static double getBraidFraction();
+static int getPixelsPerCell();
+static bool isImageFilename(string filename, MazeImageFormat & format);
+static void printProgress(const char *phase, double fractionDone);
+static void solveAndReport(const MazeBitplanes & maze);
+static void measureAndReport(const MazeBitplanes & maze, string mazeFilename);
+static void exportImageAndReport(const MazeBitplanes & maze);
+static Vector<uint32_t> initializeWallsAndChambers(int initialDimensions, MazeRandom & generator);
+static void initializeCellWalls(int cellX, int cellY, Vector<uint32_t> & originalWallVector, int originalDimensions);
+static void shuffleWalls(Vector<uint32_t> & wallVector, MazeRandom & generator);
+static int removeSeparatingWalls(const Vector<uint32_t> & wallOrder, int dimension, Vector<int> & removalOrder);
+static void drawFullGrid(MazeGeneratorView & mazeWindow, const Vector<uint32_t> & wallOrder, int dimension);
+static void animateWallRemovals(MazeGeneratorView & mazeWindow, MazeReplayCursor & cursor, int dimension, uint64_t targetStep,
+                                int framesPerSecond, int wallsPerFrame);
+static void drawFinishedMaze(MazeGeneratorView & mazeWindow, const Vector<uint32_t> & wallOrder, int dimension,
+                             const Vector<int> & removalOrder);
+static wall indexToWall(uint32_t wallIndex, int dimension);
 static const int minDimension = 7;
 static const int maxDimension = 50;
+static const int maxHeadlessDimension = 1000000;
+static const int maxHeadlessThreads = 256;
+static const int exitMode = 0;
+static const int windowMode = 1;
+static const int headlessMode = 2;
+static const int inspectMode = 3;
+static const int streamMode = 4;
+static const int benchmarkMode = 5;
+static const int chunkMode = 6;
+static const int replayMode = 7;
+static const int graphMode = 8;
+static const int farmMode = 9;
+static const int concurrentSetMode = 10;
+static const int kruskalChoice = 0;
+static const int wilsonChoice = 1;
+static const int backtrackerChoice = 2;
+static const int huntAndKillChoice = 3;
+static const int uniformWeights = 0;
+static const int corridorWeights = 1;
+static const int noiseWeights = 2;
+static const int maxPrintedWidth = 38;
+static const int maxFramesPerSecond = 120;
+static const int maxPrintedPathLength = 200;
+static const int maxCachedChunks = 1024;
+static const int maxChunkRadius = 50;
+static const uint64_t maxGraphCells = 1ULL << 28;
+static const int maxFarmDimension = 4096;
+static const int maxStressThreads = 64;
+static const int contendedStressRounds = 100;
+static const uint64_t contendedStressElements = 64;
+static const uint64_t contendedStressPairs = 1024;
+static const uint64_t sparseStressElements = 1 << 20;
 
 /*
- * This main method organizes the data necessary to animate the maze generation.
- * (Graphics details are covered in maze-graphics.cpp)
+ * This main method lets the user pick how the next maze should be generated, generates it, and repeats until the user
+ * chooses to exit.
  *
- * This method prompts the user for the dimmensions of a maze, creates a new display
- * to show that maze, stores a representation of all current cells in a set, and stores
- * all the walls (in random order) in a vector.
+ * A maze in the window is drawn on a MazeGeneratorView, either animated or all at once, and is limited to what fits in
+ * the window. A headless maze is never displayed, which lets it be far larger, and can be saved to a maze file (see
+ * maze-file.h) to be inspected later.
  *
- * These two data structures are then fed into a third method which removes every wall
- * in the vector that separates two chambers (leaving walls that separate the "same" chamber.)
- *
- * The user then hits enter to either generate another maze or to terminate the program, depending
- * on their choice.
+ * When instrumentation is compiled in (see maze-instrumentation.h), the counters start from zero for every maze, and are
+ * reported as JSON once it is done.
  */
 int main() {
     while(true){
-        int dimension = getMazeDimension("What should the dimension of your maze be [0 to exit]? ");
-        if (dimension == 0) break;
-        MazeGeneratorView mazeWindow;
-        Set<cell> cellList;
-        mazeWindow.setDimension(dimension);
-        Vector<wall> shuffledWallVector = initializeWallsAndChambers(dimension, cellList, mazeWindow);
-        removeSeparatingWalls(shuffledWallVector, mazeWindow, cellList);
+        int mode = getGenerationMode();
+        if (mode == exitMode) break;
+#ifdef MAZE_INSTRUMENTATION
+        resetMazeInstrumentation();
+#endif
+        if (mode == windowMode) {
+            generateAnimatedMaze();
+        } else if (mode == headlessMode) {
+            generateHeadlessMaze();
+        } else if (mode == inspectMode) {
+            inspectMazeFile();
+        } else if (mode == streamMode) {
+            streamEllerMaze();
+        } else if (mode == benchmarkMode) {
+            benchmarkGenerators();
+        } else if (mode == chunkMode) {
+            exploreInfiniteMaze();
+        } else if (mode == replayMode) {
+            replayAnimatedMaze();
+        } else if (mode == graphMode) {
+            carveGraphMaze();
+        } else if (mode == farmMode) {
+            farmMazeBatch();
+        } else {
+            testConcurrentDisjointSet();
+        }
+#ifdef MAZE_INSTRUMENTATION
+        reportInstrumentation();
+#endif
         getLine("Press enter to play again.");
         cout << endl;
 	}
@@ -57,6 +209,830 @@ int main() {
 	return 0;
 }
 
+/*
+ * Prompts the user for the kind of maze to generate next, and returns one of the mode constants.
+ */
+static int getGenerationMode() {
+    while (true) {
+        int response = getInteger("Generate [1] a maze in the window, [2] a headless maze, [3] inspect a maze file, "
+                                  "[4] stream a maze row by row, [5] benchmark the generators, [6] explore an infinite maze, "
+                                  "[7] replay a maze being built, [8] carve a maze through a graph of cells, "
+                                  "[9] farm a batch of mazes into an archive, "
+                                  "[10] stress-test the lock-free disjoint set, or [0] exit? ");
+        if (response >= exitMode && response <= concurrentSetMode) return response;
+        cout << "Please enter a number between " << exitMode << " and " << concurrentSetMode << ", inclusive." << endl;
+    }
+}
+
+#ifdef MAZE_INSTRUMENTATION
+/*
+ * This method writes the instrumentation counters as JSON to a file the user names, or prints them if no name is given.
+ */
+static void reportInstrumentation() {
+    string json = mazeInstrumentationJson();
+    string filename = getLine("Save the instrumentation as JSON to which file [blank to print it]? ");
+    if (filename.empty()) {
+        cout << json;
+        return;
+    }
+    ofstream output(filename.c_str());
+    output << json;
+    if (!output) cout << "Unable to write " << filename << "." << endl;
+}
+#endif
+
+/*
+ * This method organizes the data necessary to display the maze generation.
+ * (Graphics details are covered in maze-graphics.cpp)
+ *
+ * This method prompts the user for the dimmensions of a maze, creates a new display
+ * to show that maze, and stores all the walls (in random order) in a vector.
+ *
+ * This vector is then fed into a second method which works out which walls in the
+ * vector separate two chambers (leaving walls that separate the "same" chamber.)
+ * None of this touches the display, so it runs at full speed.
+ *
+ * The seed behind the random order is printed, so the maze can be reproduced.
+ * Only then is the maze drawn. If the user wants to watch it being carved, the full
+ * grid is drawn and the walls come down a frame at a time; otherwise just the walls
+ * left standing are drawn, and the window is repainted once.
+ *
+ * The walls that came down are recorded in order in a replay log (see maze-replay.h),
+ * which drives the animation and can be saved so the maze can be watched again later.
+ */
+static void generateAnimatedMaze() {
+    int dimension = getMazeDimension("What should the dimension of your maze be [0 to go back]? ");
+    if (dimension == 0) return;
+    bool animate = getYesOrNo("Do you want to watch the walls come down? ");
+    int framesPerSecond = 0;
+    int wallsPerFrame = 0;
+    if (animate) getAnimationSpeed(framesPerSecond, wallsPerFrame);
+    MazeGeneratorView mazeWindow;
+    mazeWindow.setDimension(dimension);
+    int seed = randomInteger(0, INT_MAX);
+    cout << "Generating the maze from seed " << seed << "." << endl;
+    MazeRandom generator(seed);
+    Vector<uint32_t> shuffledWallVector = initializeWallsAndChambers(dimension, generator);
+    Vector<int> removalOrder;
+    int wallsExamined = removeSeparatingWalls(shuffledWallVector, dimension, removalOrder);
+    cout << "Examined " << wallsExamined << " of " << shuffledWallVector.size() << " walls to remove "
+         << removalOrder.size() << "." << endl;
+    MazeReplayLog replay(dimension, dimension, seed);
+    for (int index : removalOrder) {
+        replay.addRemoval(shuffledWallVector[index]);
+    }
+    if (animate) {
+        drawFullGrid(mazeWindow, shuffledWallVector, dimension);
+        MazeReplayCursor cursor(replay);
+        animateWallRemovals(mazeWindow, cursor, dimension, replay.numRemovals(), framesPerSecond, wallsPerFrame);
+    } else {
+        drawFinishedMaze(mazeWindow, shuffledWallVector, dimension, removalOrder);
+    }
+    if (getYesOrNo("Do you want to save a replay of the maze being built? ")) {
+        string filename = getLine("Enter the name of the replay file: ");
+        if (!replay.save(filename)) cout << "Unable to write " << filename << "." << endl;
+    }
+}
+
+/*
+ * This method generates a maze without ever displaying it (see maze-headless.h). The user picks the width, the height, a
+ * seed, and an algorithm: Kruskal's with a choice of wall weights and some number of threads, Wilson's, the recursive
+ * backtracker, or hunt-and-kill. The same answers always produce the same maze. Progress is printed while the maze is
+ * generated, followed by a summary of how long it took and how much memory the finished maze takes up. The user can then
+ * braid away some of the dead ends (see maze-braid.h), and solve, save, measure and export an image of the maze.
+ */
+static void generateHeadlessMaze() {
+    uint64_t width = getHeadlessDimension("How many cells wide should the maze be? ");
+    uint64_t height = getHeadlessDimension("How many cells tall should the maze be? ");
+    uint64_t seed = getSeed("What seed should generate the maze? ");
+    int choice = getHeadlessAlgorithm();
+    bool useKruskal = choice == kruskalChoice;
+    int wallWeights = useKruskal ? getWallWeights() : uniformWeights;
+    int numThreads = useKruskal ? getHeadlessThreads("How many threads should generate the maze? ") : 1;
+    uint64_t memoryNeeded = choice == wilsonChoice ? wilsonMemoryEstimate(width, height)
+                          : choice == backtrackerChoice ? backtrackerMemoryEstimate(width, height)
+                          : choice == huntAndKillChoice ? huntAndKillMemoryEstimate(width, height)
+                          : wallWeights == uniformWeights ? parallelKruskalMemoryEstimate(width, height)
+                          : weightedKruskalMemoryEstimate(width, height);
+    cout << "Generating needs about " << memoryNeeded / (1024 * 1024) << " MB of memory." << endl;
+    try {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        MazeBitplanes maze(width, height);
+        uint64_t wallsRemoved;
+        uint64_t wallsExamined = 0;
+        MazeAlgorithm algorithm;
+        if (choice == wilsonChoice) {
+            wallsRemoved = generateWilsonMaze(maze, seed, printProgress);
+            algorithm = WILSON_ALGORITHM;
+        } else if (choice == backtrackerChoice) {
+            wallsRemoved = generateBacktrackerMaze(maze, seed, printProgress);
+            algorithm = BACKTRACKER_ALGORITHM;
+        } else if (choice == huntAndKillChoice) {
+            wallsRemoved = generateHuntAndKillMaze(maze, seed, printProgress);
+            algorithm = HUNT_AND_KILL_ALGORITHM;
+        } else if (wallWeights == corridorWeights) {
+            wallsRemoved = generateWeightedKruskalMaze(maze, seed, corridorWallWeight, numThreads, wallsExamined, printProgress);
+            algorithm = CORRIDOR_KRUSKAL_ALGORITHM;
+        } else if (wallWeights == noiseWeights) {
+            wallsRemoved = generateWeightedKruskalMaze(maze, seed, noiseWallWeight, numThreads, wallsExamined, printProgress);
+            algorithm = NOISE_KRUSKAL_ALGORITHM;
+        } else {
+            wallsRemoved = generateParallelKruskalMaze(maze, seed, numThreads, wallsExamined, printProgress);
+            algorithm = PARALLEL_KRUSKAL_ALGORITHM;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Removed " << wallsRemoved << " walls from a " << width << "x" << height << " maze with seed " << seed << " in "
+             << seconds << " seconds (" << maze.numCells() / seconds << " cells per second)." << endl;
+        if (useKruskal) cout << "Examined " << wallsExamined << " walls along the way." << endl;
+        cout << "The finished maze takes up " << maze.memoryUsage() << " bytes." << endl;
+        double braidFraction = getBraidFraction();
+        if (braidFraction > 0) {
+            start = chrono::steady_clock::now();
+            uint64_t wallsBraided = braidMaze(maze, seed, braidFraction, numThreads);
+            cout << "Braided the maze by removing " << wallsBraided << " more walls in "
+                 << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds." << endl;
+        }
+        if (getYesOrNo("Do you want to solve the maze? ")) solveAndReport(maze);
+        string filename;
+        if (getYesOrNo("Do you want to save the maze to a file? ")) {
+            filename = getLine("Enter the name of the maze file: ");
+            if (!saveMaze(maze, filename, seed, algorithm)) {
+                cout << "Unable to write " << filename << "." << endl;
+                filename = "";
+            }
+        }
+        if (getYesOrNo("Do you want to measure the maze? ")) measureAndReport(maze, filename);
+        if (getYesOrNo("Do you want to export an image of the maze? ")) exportImageAndReport(maze);
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to generate a maze that large." << endl;
+    }
+}
+
+/*
+ * This method maps a saved maze file into memory, prints what its header says about the maze, and checks that the walls
+ * stored in it still match the checksum recorded when it was written. The user can then solve, measure and export an image
+ * of the mapped maze in place.
+ */
+static void inspectMazeFile() {
+    MappedMazeFile mapped;
+    string filename = getLine("Enter the name of the maze file: ");
+    if (!mapped.open(filename)) {
+        cout << "Unable to read " << filename << " as a maze file." << endl;
+        return;
+    }
+    const mazeFileHeader & header = mapped.header();
+    cout << "The maze is " << header.width << "x" << header.height << ", generated by algorithm " << header.algorithm
+         << " from seed " << header.seed << "." << endl;
+    cout << (mapped.verifyChecksum() ? "The checksum matches." : "The checksum does NOT match; the file is damaged.") << endl;
+    if (getYesOrNo("Do you want to solve the maze? ")) solveAndReport(mapped.maze());
+    if (getYesOrNo("Do you want to measure the maze? ")) measureAndReport(mapped.maze(), filename);
+    if (getYesOrNo("Do you want to export an image of the maze? ")) exportImageAndReport(mapped.maze());
+}
+
+/*
+ * This method solves a maze from its top-left cell to its bottom-right cell (see maze-solver.h) and prints how long the path
+ * is, how many cells were searched and how quickly. Short paths are printed as well, one letter per move.
+ */
+static void solveAndReport(const MazeBitplanes & maze) {
+    try {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        string path;
+        uint64_t cellsVisited;
+        bool solved = solveMaze(maze, 0, maze.numCells() - 1, path, cellsVisited);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (!solved) {
+            cout << "There is no path from the top-left cell to the bottom-right cell." << endl;
+        } else {
+            cout << "Found a path of " << path.size() << " moves." << endl;
+            if (path.size() <= (size_t) maxPrintedPathLength) cout << "Path: " << path << endl;
+        }
+        cout << "Searched " << cellsVisited << " cells in " << seconds << " seconds (" << cellsVisited / seconds
+             << " cells per second)." << endl;
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to solve a maze that large." << endl;
+    }
+}
+
+/*
+ * This method measures a maze (see maze-metrics.h) using every core available and prints the results. If the maze has been
+ * saved, the metrics are also written as JSON to a file alongside it, named after the maze file with ".json" added.
+ */
+static void measureAndReport(const MazeBitplanes & maze, string mazeFilename) {
+    try {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        mazeMetrics metrics = measureMaze(maze, max(1, (int) thread::hardware_concurrency()));
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Dead ends: " << metrics.deadEnds << ", junctions: " << metrics.junctions << ", diameter: "
+             << metrics.diameter << " moves." << endl;
+        if (metrics.solvable) {
+            cout << "Solution: " << metrics.solutionLength << " moves with " << metrics.solutionTurns << " turns." << endl;
+        } else {
+            cout << "The maze has no solution." << endl;
+        }
+        cout << "Measured in " << seconds << " seconds." << endl;
+        if (mazeFilename != "" && !saveMetrics(metrics, mazeFilename + ".json")) {
+            cout << "Unable to write " << mazeFilename << ".json." << endl;
+        }
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to measure a maze that large." << endl;
+    }
+}
+
+/*
+ * This method renders a maze into a PNG or PBM image (see maze-image.h), named by the user, and prints how long it took.
+ */
+static void exportImageAndReport(const MazeBitplanes & maze) {
+    MazeImageFormat format;
+    string filename = getLine("Enter the name of the image file (.png or .pbm): ");
+    while (!isImageFilename(filename, format)) {
+        filename = getLine("The name must end in .png or .pbm. Try again: ");
+    }
+    int pixelsPerCell = getPixelsPerCell();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!exportMazeImage(maze, filename, format, pixelsPerCell, true)) {
+        cout << "Unable to write " << filename << "." << endl;
+        return;
+    }
+    cout << "Exported the maze to " << filename << " in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds." << endl;
+}
+
+/*
+ * This method generates a maze with Eller's algorithm (see maze-headless.h), which never holds more than one row in memory.
+ * Each row is streamed straight into a maze file or a PNG or PBM image as soon as it is finished or, for narrow mazes,
+ * printed on the console.
+ */
+static void streamEllerMaze() {
+    uint64_t width = getHeadlessDimension("How many cells wide should the maze be? ");
+    int height = getInteger("How many rows should be streamed? ");
+    if (height < 1) return;
+    uint64_t seed = getSeed("What seed should generate the maze? ");
+    string filename = getLine("Enter the name of the maze file or a .png or .pbm image [blank to print the maze]: ");
+    MazeImageFormat format;
+    int pixelsPerCell = isImageFilename(filename, format) ? getPixelsPerCell() : 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t rows;
+    if (filename == "") {
+        if (width > maxPrintedWidth) {
+            cout << "Only mazes up to " << maxPrintedWidth << " cells wide can be printed." << endl;
+            return;
+        }
+        ConsoleRowSink printer(width);
+        rows = generateEllerMaze(width, height, seed, printer, NULL);
+    } else if (pixelsPerCell > 0) {
+        MazeImageWriter writer;
+        if (!writer.open(filename, format, width, pixelsPerCell, true)) {
+            cout << "Unable to write " << filename << "." << endl;
+            return;
+        }
+        rows = generateEllerMaze(width, height, seed, writer, printProgress);
+        if (!writer.close()) cout << "Unable to finish writing " << filename << "." << endl;
+    } else {
+        MazeFileWriter writer;
+        if (!writer.open(filename, width, seed, ELLER_ALGORITHM)) {
+            cout << "Unable to write " << filename << "." << endl;
+            return;
+        }
+        rows = generateEllerMaze(width, height, seed, writer, printProgress);
+        if (!writer.close()) cout << "Unable to finish writing " << filename << "." << endl;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Streamed " << rows << " rows of " << width << " cells in " << seconds << " seconds." << endl;
+}
+
+/*
+ * This method carves a maze through a graph of cells (see maze-graph.h) rather than a square grid. The user picks the shape of
+ * the grid, its size, a seed, and Kruskal's or Wilson's algorithm. The time taken to build the graph and to carve the maze are
+ * printed separately, along with how much memory the graph takes up. Rectangular and disc-shaped mazes can then be turned into
+ * bitplanes and exported as images like any other headless maze. Rectangular ones can be solved and measured as well; both
+ * start from the top-left cell, which a disc leaves out.
+ */
+static void carveGraphMaze() {
+    int shape = getGraphShape();
+    uint64_t width = getHeadlessDimension("How many cells wide should the maze be? ");
+    uint64_t height = getHeadlessDimension("How many cells tall should the maze be? ");
+    uint64_t layers = shape == LAYERED_GRAPH ? getHeadlessDimension("How many layers should the maze have? ") : 1;
+    if (width * height * layers > maxGraphCells) {
+        cout << "Graph mazes may have at most " << maxGraphCells << " cells." << endl;
+        return;
+    }
+    uint64_t seed = getSeed("What seed should generate the maze? ");
+    bool useWilson = getYesOrNo("Use Wilson's algorithm, which makes every maze equally likely? ");
+    try {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        mazeGraph graph;
+        if (shape == RECTANGULAR_GRAPH) {
+            buildRectangularGraph(width, height, graph);
+        } else if (shape == HEXAGONAL_GRAPH) {
+            buildHexagonalGraph(width, height, graph);
+        } else if (shape == TRIANGULAR_GRAPH) {
+            buildTriangularGraph(width, height, graph);
+        } else if (shape == MASKED_GRAPH) {
+            vector<bool> mask;
+            makeDiscMask(width, height, mask);
+            buildMaskedGraph(width, height, mask, graph);
+        } else {
+            buildLayeredGraph(width, height, layers, graph);
+        }
+        cout << "Built a graph of " << graph.numCells << " cells and " << graph.edges.size() << " walls in "
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds; it takes up "
+             << graphMemoryEstimate(graph) / (1024 * 1024) << " MB." << endl;
+
+        start = chrono::steady_clock::now();
+        vector<uint64_t> passages;
+        uint64_t edgesExamined = 0;
+        if (useWilson) {
+            generateGraphWilsonMaze(graph, seed, passages);
+        } else {
+            generateGraphKruskalMaze(graph, seed, passages, edgesExamined);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Carved " << passages.size() << " passages with seed " << seed << " in " << seconds << " seconds ("
+             << graph.numCells / seconds << " cells per second)." << endl;
+        if (!useWilson) cout << "Examined " << edgesExamined << " walls along the way." << endl;
+        if (passages.size() + 1 < graph.numCells) {
+            cout << "The cells fall into " << graph.numCells - passages.size() << " separate mazes." << endl;
+        }
+
+        MazeBitplanes maze;
+        if (!graphMazeToBitplanes(graph, passages, maze)) return;
+        if (shape == RECTANGULAR_GRAPH) {
+            if (getYesOrNo("Do you want to solve the maze? ")) solveAndReport(maze);
+            if (getYesOrNo("Do you want to measure the maze? ")) measureAndReport(maze, "");
+        }
+        if (getYesOrNo("Do you want to export an image of the maze? ")) exportImageAndReport(maze);
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to carve a maze that large." << endl;
+    }
+}
+
+/*
+ * This method checks the lock-free disjoint-set structure (see ConcurrentDisjointSet in maze-disjoint-set.h) and measures how
+ * a maze generated with it scales. For 1, 2, 4 and so on up to maxStressThreads threads, it runs stressConcurrentSet many times
+ * over a handful of elements, so the threads fight over the same few roots, and once over many elements, so the sets left at
+ * the end are worth comparing. It then times generateConcurrentKruskalMaze on a maze of the size the user picks, and prints
+ * the speedup over one thread.
+ */
+static void testConcurrentDisjointSet() {
+    uint64_t seed = getSeed("What seed should drive the stress test? ");
+    uint64_t width = getHeadlessDimension("How many cells wide should the benchmark maze be? ");
+    uint64_t height = getHeadlessDimension("How many cells tall should the benchmark maze be? ");
+    cout << left << setw(10) << "Threads" << setw(14) << "Stress test" << right << setw(12) << "Seconds" << setw(16)
+         << "Cells/second" << setw(10) << "Speedup" << endl;
+    try {
+        MazeBitplanes maze;
+        double oneThreadSeconds = 0;
+        for (int numThreads = 1; numThreads <= maxStressThreads; numThreads *= 2) {
+            bool passed = true;
+            for (int round = 0; round < contendedStressRounds && passed; round++) {
+                passed = stressConcurrentSet(numThreads, contendedStressElements, contendedStressPairs, seed + round);
+            }
+            if (passed) {
+                passed = stressConcurrentSet(numThreads, sparseStressElements, sparseStressElements / 2 / numThreads, seed);
+            }
+            maze.resize(width, height);
+            uint64_t wallsExamined;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            generateConcurrentKruskalMaze(maze, seed, numThreads, wallsExamined, NULL);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (numThreads == 1) oneThreadSeconds = seconds;
+            cout << left << setw(10) << numThreads << setw(14) << (passed ? "passed" : "FAILED") << right << fixed
+                 << setprecision(3) << setw(12) << seconds << setprecision(0) << setw(16) << maze.numCells() / seconds
+                 << setprecision(2) << setw(10) << oneThreadSeconds / seconds << endl;
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        }
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to benchmark a maze that large." << endl;
+    }
+}
+
+/*
+ * This method has numThreads threads merge pairsPerThread random pairs of elements each into one ConcurrentDisjointSet, all at
+ * once, and returns whether it ended up where merging them one at a time would have. The pairs come from counterRandom, so they
+ * can be merged again afterwards, on this thread, into a DisjointSet. Whatever order the merges ran in, the sets at the end must
+ * match, and every join of two sets must have been reported to exactly one thread, so the merges that returned true must
+ * number the elements less the sets left. After each merge, its thread also checks that the two elements share a set, since
+ * nothing can split them again.
+ */
+static bool stressConcurrentSet(int numThreads, uint64_t numElements, uint64_t pairsPerThread, uint64_t seed) {
+    ConcurrentDisjointSet sets(numElements);
+    vector<uint64_t> merges(numThreads, 0);
+    vector<char> consistent(numThreads, true);
+    auto work = [&](int index) {
+        for (uint64_t i = 0; i < pairsPerThread; i++) {
+            uint64_t pair = counterRandom(seed, ((uint64_t) index << 32) | i);
+            uint64_t one = (pair & 0xffffffff) % numElements;
+            uint64_t two = (pair >> 32) % numElements;
+            if (sets.merge(one, two)) merges[index]++;
+            if (!sets.sameSet(one, two)) consistent[index] = false;
+        }
+    };
+    vector<thread> workers;
+    for (int i = 1; i < numThreads; i++) {
+        workers.push_back(thread(work, i));
+    }
+    work(0);
+    for (uint64_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    DisjointSet expected(numElements);
+    uint64_t totalMerges = 0;
+    for (int index = 0; index < numThreads; index++) {
+        if (!consistent[index]) return false;
+        totalMerges += merges[index];
+        for (uint64_t i = 0; i < pairsPerThread; i++) {
+            uint64_t pair = counterRandom(seed, ((uint64_t) index << 32) | i);
+            expected.merge((pair & 0xffffffff) % numElements, (pair >> 32) % numElements);
+        }
+    }
+    if (totalMerges != numElements - expected.countSets() || sets.countSets() != expected.countSets()) return false;
+    vector<uint64_t> matchingRoot(numElements, numElements);
+    for (uint64_t i = 0; i < numElements; i++) {
+        uint64_t root = expected.find(i);
+        if (matchingRoot[root] == numElements) matchingRoot[root] = sets.find(i);
+        if (matchingRoot[root] != sets.find(i)) return false;
+    }
+    return true;
+}
+
+/*
+ * This method runs a maze farm (see maze-farm.h): the user picks how many mazes to generate, the range of sizes they are drawn
+ * from, a seed, how long a maze's solution must be for it to be kept, and how many threads to use. The accepted mazes are
+ * written to an archive, and the number of mazes per second and the time spent in each stage are printed. The archive can then
+ * be read back to check every maze in it against its checksum.
+ */
+static void farmMazeBatch() {
+    farmOptions options;
+    int count = getInteger("How many mazes should the farm generate? ");
+    if (count < 1) return;
+    options.count = count;
+    options.minWidth = getFarmDimension("How many cells wide should the narrowest maze be? ", 1);
+    options.maxWidth = getFarmDimension("How many cells wide should the widest maze be? ", options.minWidth);
+    options.minHeight = getFarmDimension("How many cells tall should the shortest maze be? ", 1);
+    options.maxHeight = getFarmDimension("How many cells tall should the tallest maze be? ", options.minHeight);
+    options.seed = getSeed("What seed should generate the mazes? ");
+    options.minSolutionRatio = getReal("How many times the corner-to-corner distance must a solution be to keep its maze "
+                                       "(0 to keep every maze)? ");
+    options.numThreads = getHeadlessThreads("How many threads should farm the mazes? ");
+    string filename = getLine("Enter the name of the archive: ");
+    farmReport report;
+    try {
+        if (!runMazeFarm(options, filename, report, printProgress)) {
+            cout << "Unable to write " << filename << "." << endl;
+            return;
+        }
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to farm that many mazes." << endl;
+        return;
+    }
+    cout << "Generated " << report.generated << " mazes in " << report.totalSeconds << " seconds ("
+         << report.generated / report.totalSeconds << " mazes per second) and kept " << report.accepted << "." << endl;
+    cout << "The archive takes up " << report.archiveBytes << " bytes." << endl;
+    cout << "Seconds spent across all threads generating: " << report.generateSeconds << ", measuring: "
+         << report.measureSeconds << ", packing: " << report.packSeconds << ", writing: " << report.writeSeconds << "." << endl;
+    cout << "Threads stole work from each other " << report.stolenBatches << " times." << endl;
+
+    if (!getYesOrNo("Do you want to check the archive? ")) return;
+    MazeFarmArchive archive;
+    if (!archive.open(filename)) {
+        cout << "Unable to read " << filename << " as a farm archive." << endl;
+        return;
+    }
+    MazeBitplanes maze;
+    uint64_t damaged = 0;
+    for (uint64_t i = 0; i < archive.numMazes(); i++) {
+        if (!archive.loadMaze(i, maze)) damaged++;
+    }
+    cout << "Read " << archive.numMazes() << " mazes back; " << damaged << " did not match their checksums." << endl;
+}
+
+/*
+ * This method generates the same maze size from the same seed with each headless generator in turn, and prints how many
+ * cells per second each one managed and how much memory it needed, so the generators can be compared. The parallel
+ * generators use one thread per core. Kruskal's and Wilson's algorithms are also timed on the same grid built as a graph (see
+ * maze-graph.h), when it is small enough to build; the time to build the graph is not counted. The graph is built as a mask
+ * with no holes rather than as a rectangle, since a rectangular graph is handed straight to generateWilsonMaze and would not
+ * time the graph engine at all. The last line times braiding every dead end out of the last maze generated. The user can
+ * also ask for the row-major and Morton cell layouts to be compared (see compareCellLayouts).
+ */
+static void benchmarkGenerators() {
+    uint64_t width = getHeadlessDimension("How many cells wide should the benchmark mazes be? ");
+    uint64_t height = getHeadlessDimension("How many cells tall should the benchmark mazes be? ");
+    uint64_t seed = getSeed("What seed should generate the mazes? ");
+    bool compareLayouts = getYesOrNo("Do you want to compare the row-major and Morton cell layouts as well? ");
+    int numThreads = max(2, (int) thread::hardware_concurrency());
+    cout << left << setw(24) << "Generator" << right << setw(12) << "Seconds" << setw(16) << "Cells/second"
+         << setw(12) << "Memory MB" << endl;
+    try {
+        MazeBitplanes maze(width, height);
+        uint64_t wallsExamined;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        generateKruskalMaze(maze, seed, wallsExamined, NULL);
+        printBenchmarkLine("Kruskal", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), kruskalMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateParallelKruskalMaze(maze, seed, numThreads, wallsExamined, NULL);
+        printBenchmarkLine("Kruskal, " + integerToString(numThreads) + " threads",
+                           chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), parallelKruskalMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateConcurrentKruskalMaze(maze, seed, numThreads, wallsExamined, NULL);
+        printBenchmarkLine("Lock-free Kruskal", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), concurrentKruskalMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateWeightedKruskalMaze(maze, seed, uniformWallWeight, numThreads, wallsExamined, NULL);
+        printBenchmarkLine("Kruskal, radix sorted", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), weightedKruskalMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateWilsonMaze(maze, seed, NULL);
+        printBenchmarkLine("Wilson", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), wilsonMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateBacktrackerMaze(maze, seed, NULL);
+        printBenchmarkLine("Recursive backtracker", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), backtrackerMemoryEstimate(width, height));
+
+        maze.resize(width, height);
+        start = chrono::steady_clock::now();
+        generateHuntAndKillMaze(maze, seed, NULL);
+        printBenchmarkLine("Hunt-and-kill", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), huntAndKillMemoryEstimate(width, height));
+
+        if (width * height <= maxGraphCells) {
+            mazeGraph graph;
+            buildMaskedGraph(width, height, vector<bool>(width * height, true), graph);
+            vector<uint64_t> passages;
+            start = chrono::steady_clock::now();
+            generateGraphKruskalMaze(graph, seed, passages, wallsExamined);
+            printBenchmarkLine("Kruskal on a graph", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                               graph.numCells, graphMemoryEstimate(graph) + graph.edges.size() * sizeof(uint64_t)
+                               + graph.numCells * (2 * sizeof(uint64_t) + 1));
+            start = chrono::steady_clock::now();
+            generateGraphWilsonMaze(graph, seed, passages);
+            printBenchmarkLine("Wilson on a graph", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                               graph.numCells, graphMemoryEstimate(graph) + graph.numCells * (sizeof(uint64_t) + 1)
+                               + graph.numCells / 4);
+        }
+
+        maze.resize(width, height);
+        BitplanesRowSink sink(maze);
+        start = chrono::steady_clock::now();
+        generateEllerMaze(width, height, seed, sink, NULL);
+        printBenchmarkLine("Eller", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), maze.memoryUsage() + ellerMemoryEstimate(width));
+
+        start = chrono::steady_clock::now();
+        braidMaze(maze, seed, 1, numThreads);
+        printBenchmarkLine("Braid every dead end", chrono::duration<double>(chrono::steady_clock::now() - start).count(),
+                           maze.numCells(), maze.memoryUsage() + maze.numCells() / 8);
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to benchmark mazes that large." << endl;
+        return;
+    }
+    if (compareLayouts) compareCellLayouts(width, height, seed);
+}
+
+/*
+ * This method runs serial Kruskal, Wilson, and the solver on a Wilson maze, each once with its per-cell working arrays in
+ * row-major order and once in Morton order (see maze-morton.h), and prints how long each run took and how many cache misses
+ * it caused. Both layouts build and solve exactly the same mazes, so only the memory traffic differs.
+ */
+static void compareCellLayouts(uint64_t width, uint64_t height, uint64_t seed) {
+    static const MazeCellLayout layouts[2] = { ROW_MAJOR_LAYOUT, MORTON_LAYOUT };
+    static const char *layoutNames[2] = { "row-major", "Morton" };
+    cout << endl << left << setw(24) << "Layout" << right << setw(12) << "Seconds" << setw(16) << "Cache misses" << endl;
+    try {
+        MazeBitplanes maze;
+        CacheMissCounter counter;
+        for (int i = 0; i < 2; i++) {
+            maze.resize(width, height);
+            kruskalScratch scratch;
+            uint64_t wallsExamined;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            counter.start();
+            generateKruskalMaze(maze, seed, wallsExamined, NULL, scratch, layouts[i]);
+            int64_t cacheMisses = counter.stop();
+            printLayoutLine(string("Kruskal, ") + layoutNames[i],
+                            chrono::duration<double>(chrono::steady_clock::now() - start).count(), cacheMisses);
+        }
+        for (int i = 0; i < 2; i++) {
+            maze.resize(width, height);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            counter.start();
+            generateWilsonMaze(maze, seed, NULL, layouts[i]);
+            int64_t cacheMisses = counter.stop();
+            printLayoutLine(string("Wilson, ") + layoutNames[i],
+                            chrono::duration<double>(chrono::steady_clock::now() - start).count(), cacheMisses);
+        }
+        for (int i = 0; i < 2; i++) {
+            string path;
+            uint64_t cellsVisited;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            counter.start();
+            solveMaze(maze, 0, maze.numCells() - 1, path, cellsVisited, layouts[i]);
+            int64_t cacheMisses = counter.stop();
+            printLayoutLine(string("Solve, ") + layoutNames[i],
+                            chrono::duration<double>(chrono::steady_clock::now() - start).count(), cacheMisses);
+        }
+    } catch (bad_alloc &) {
+        cout << "There is not enough memory to compare layouts on mazes that large." << endl;
+    }
+}
+
+/*
+ * Prints one line of the benchmark table.
+ */
+static void printBenchmarkLine(string name, double seconds, uint64_t numCells, uint64_t memoryNeeded) {
+    cout << left << setw(24) << name << right << fixed << setprecision(3) << setw(12) << seconds
+         << setprecision(0) << setw(16) << numCells / seconds
+         << setprecision(1) << setw(12) << memoryNeeded / (1024.0 * 1024.0) << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+/*
+ * Prints one line of the layout comparison, with "n/a" for a cache miss count that could not be read.
+ */
+static void printLayoutLine(string name, double seconds, int64_t cacheMisses) {
+    cout << left << setw(24) << name << right << fixed << setprecision(3) << setw(12) << seconds << setw(16)
+         << (cacheMisses < 0 ? string("n/a") : to_string(cacheMisses)) << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+ConsoleRowSink::ConsoleRowSink(uint64_t width) {
+    mazeWidth = width;
+}
+
+/*
+ * The top border is drawn along with the first row. Every row after that is drawn as a line of cells and east walls, followed
+ * by a line of south walls.
+ */
+bool ConsoleRowSink::acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords) {
+    if (row == 0) {
+        cout << "+";
+        for (uint64_t col = 0; col < mazeWidth; col++) cout << "--+";
+        cout << endl;
+    }
+    cout << "|";
+    for (uint64_t col = 0; col < mazeWidth; col++) {
+        cout << (((eastWords[col / 64] >> (col % 64)) & 1) ? "  |" : "   ");
+    }
+    cout << endl << "+";
+    for (uint64_t col = 0; col < mazeWidth; col++) {
+        cout << (((southWords[col / 64] >> (col % 64)) & 1) ? "--+" : "  +");
+    }
+    cout << endl;
+    return true;
+}
+
+/*
+ * The counter is opened disabled, for this thread on any processor, counting only misses in user code.
+ */
+CacheMissCounter::CacheMissCounter() {
+    descriptor = -1;
+#ifdef __linux__
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    descriptor = syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter() {
+#ifdef __linux__
+    if (descriptor >= 0) close(descriptor);
+#endif
+}
+
+void CacheMissCounter::start() {
+#ifdef __linux__
+    if (descriptor < 0) return;
+    ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+    ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+int64_t CacheMissCounter::stop() {
+#ifdef __linux__
+    if (descriptor < 0) return -1;
+    ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+    int64_t count;
+    if (read(descriptor, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * This method grows an infinite maze from a seed (see maze-chunks.h). It generates the square of chunks around the origin out
+ * to a radius the user picks and reports how long each chunk took, then lets the user look up chunks anywhere in the maze and
+ * see where their doors are. Chunks come through a MazeChunkCache, so chunks looked up again are not regenerated.
+ */
+static void exploreInfiniteMaze() {
+    uint64_t seed = getSeed("What seed should grow the maze? ");
+    int radius = getInteger("How many chunks out from the origin should be generated? ");
+    if (radius < 0) radius = 0;
+    if (radius > maxChunkRadius) radius = maxChunkRadius;
+    MazeChunkCache cache(seed, maxCachedChunks);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int chunkY = -radius; chunkY <= radius; chunkY++) {
+        for (int chunkX = -radius; chunkX <= radius; chunkX++) {
+            cache.getChunk(chunkX, chunkY);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Generated " << cache.misses() << " chunks of " << kChunkSize << "x" << kChunkSize << " cells, "
+         << seconds * 1000 / cache.misses() << " ms per chunk." << endl;
+    while (getYesOrNo("Do you want to look up a chunk? ")) {
+        int chunkX = getInteger("Chunk column: ");
+        int chunkY = getInteger("Chunk row: ");
+        const mazeChunk & chunk = cache.getChunk(chunkX, chunkY);
+        int eastDoor = -1;
+        int southDoor = -1;
+        for (int i = 0; i < kChunkSize; i++) {
+            if (!chunk.maze.hasEastWall(i, kChunkSize - 1)) eastDoor = i;
+            if (!chunk.maze.hasSouthWall(kChunkSize - 1, i)) southDoor = i;
+        }
+        cout << "Doors: west " << chunk.westDoor << ", north " << chunk.northDoor << ", east " << eastDoor
+             << ", south " << southDoor << " (-1 means none)." << endl;
+        cout << "The cache holds " << cache.size() << " chunks after " << cache.hits() << " hits and "
+             << cache.misses() << " misses." << endl;
+    }
+}
+
+/*
+ * This method loads a replay log saved by generateAnimatedMaze and replays it in a MazeGeneratorView. The full grid is drawn
+ * first, and the user can then play the removals forward or in reverse at any speed, or jump straight to any step; a jump
+ * applies every removal in between without pausing and repaints the window once.
+ */
+static void replayAnimatedMaze() {
+    MazeReplayLog replay;
+    string filename = getLine("Enter the name of the replay file: ");
+    if (!replay.load(filename)) {
+        cout << "Unable to read " << filename << " as a replay file." << endl;
+        return;
+    }
+    if (replay.width() != replay.height() || replay.width() < (uint64_t) minDimension
+            || replay.width() > (uint64_t) maxDimension) {
+        cout << "Only square mazes from " << minDimension << " to " << maxDimension << " cells on a side can be replayed."
+             << endl;
+        return;
+    }
+    int dimension = replay.width();
+    cout << "The replay shows " << replay.numRemovals() << " walls coming down in a " << dimension << "x" << dimension
+         << " maze from seed " << replay.seed() << ", stored in " << replay.numBytes() << " bytes." << endl;
+    int framesPerSecond;
+    int wallsPerFrame;
+    getAnimationSpeed(framesPerSecond, wallsPerFrame);
+    MazeGeneratorView mazeWindow;
+    mazeWindow.setDimension(dimension);
+    Vector<uint32_t> allWalls;
+    for (int row = 0; row < dimension; row++) {
+        for (int col = 0; col < dimension; col++) {
+            initializeCellWalls(row, col, allWalls, dimension);
+        }
+    }
+    drawFullGrid(mazeWindow, allWalls, dimension);
+    MazeReplayCursor cursor(replay);
+    while (true) {
+        string command = toLowerCase(getLine("[p]lay, play in [r]everse, [j]ump to a step, change the [s]peed, or [q]uit? "));
+        if (command == "p") {
+            animateWallRemovals(mazeWindow, cursor, dimension, replay.numRemovals(), framesPerSecond, wallsPerFrame);
+        } else if (command == "r") {
+            animateWallRemovals(mazeWindow, cursor, dimension, 0, framesPerSecond, wallsPerFrame);
+        } else if (command == "j") {
+            int step = getInteger("Jump to which step (0 to " + integerToString(replay.numRemovals()) + ")? ");
+            if (step < 0) step = 0;
+            if ((uint64_t) step > replay.numRemovals()) step = replay.numRemovals();
+            animateWallRemovals(mazeWindow, cursor, dimension, step, 0, wallsPerFrame);
+        } else if (command == "s") {
+            getAnimationSpeed(framesPerSecond, wallsPerFrame);
+        } else if (command == "q") {
+            break;
+        }
+        cout << "At step " << cursor.position() << " of " << replay.numRemovals() << "." << endl;
+    }
+}
+
 /*
  * Prompts a number from the user which is returned to the main method. This number will determine the height & width (in cells) of
  * the maze.
@@ -73,159 +1049,339 @@ static int getMazeDimension(string prompt) {
 }
 
 /*
- * This method both returns a shuffled vectors of all walls in the current maze to the main method, as well as modifying a set of cells
- * to reflect the total number of cells currently present in the maze. In addition, this method is also responsible for drawing the intitial
- * grid (without any walls removed) on the MazeGeneratorView.
- *
- * Speficially, this method creates an initial wall vector to start. A cell is generated for every possible coordinate pair given the dimensions of the
- * maze, and for each cell, the walls that bind that cell are added to the initial wall vector. All cells are also added to a Set, which will later be
- * used to keep track of which cells have been 'merged' and which cells have been 'unmerged.'
- *
- * Once this is all done, the initial wall vector (which now contains every wall in the maze), is shuffled. This shuffled vector is what is returned to the main
- * method.
+ * Prompts the user for how fast walls should come down in an animation: the number of frames shown each second, and the
+ * number of walls that come down (or go back up) in each frame.
  */
-static Vector<wall> initializeWallsAndChambers(int initialDimensions, Set<cell> & initialCellList, MazeGeneratorView & mazeWindow){
-    Vector <wall> initialWallVector;
-    mazeWindow.drawBorder();
-    for (int i = 0; i < initialDimensions; i++){
-        for (int j = 0; j < initialDimensions; j++){
-            cell newCell;
-            newCell.row = i;
-            newCell.col = j;
-            initialCellList.add(newCell);
-            initializeCellWalls(i, j, initialWallVector, initialDimensions, mazeWindow);
-        }
-    }
-    Vector<wall> newlyShuffledWallVector = shuffleWalls(initialWallVector);
-    return newlyShuffledWallVector;
-}
-
-/*
- * This method checks to see if a cell has space directly south and directly east of it for a new wall. If there is space for it, a wall is drawn on
- * the MazeGeneratorView and a wall is added to a vector.
- */
-static void initializeCellWalls(int cellX, int cellY, Vector <wall> & originalWallVector, int originalDimensions, MazeGeneratorView & originalWindow){
-    wall newWall;
-    cell cellOne;
-    cellOne.row = cellX;
-    cellOne.col = cellY;
-    cell cellTwo;
-    for (int i = 0; i <= 1; i++){
-        for (int j = 0; j <= 1; j++){
-            if ( i != j ) {
-                if ((cellX + i < originalDimensions) && (cellY + j < originalDimensions)) {
-                    cellTwo.row = cellX + i;
-                    cellTwo.col = cellY + j;
-                    newWall.one = cellOne;
-                    newWall.two = cellTwo;
-                    originalWallVector.add(newWall);
-                    originalWindow.drawWall(newWall);
-                }
-             }
-           }
+static void getAnimationSpeed(int & framesPerSecond, int & wallsPerFrame) {
+    framesPerSecond = getInteger("How many frames per second should the animation show? ");
+    if (framesPerSecond < 1) framesPerSecond = 1;
+    if (framesPerSecond > maxFramesPerSecond) framesPerSecond = maxFramesPerSecond;
+    wallsPerFrame = getInteger("How many walls should come down each frame? ");
+    if (wallsPerFrame < 1) wallsPerFrame = 1;
+}
+
+/*
+ * Prompts the user for one side of a headless maze. Headless mazes are never drawn, so they may be anywhere from a single
+ * cell up to maxHeadlessDimension cells on a side.
+ */
+static int getHeadlessDimension(string prompt) {
+    while (true) {
+        int response = getInteger(prompt);
+        if (response >= 1 && response <= maxHeadlessDimension) return response;
+        cout << "Please enter a number between 1 and "
+             << maxHeadlessDimension << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Prompts the user for the algorithm a headless maze should be generated with, and returns one of the algorithm choice
+ * constants.
+ */
+static int getHeadlessAlgorithm() {
+    while (true) {
+        int response = getInteger("Which algorithm: [0] Kruskal's, [1] Wilson's, which makes every maze equally likely, "
+                                  "[2] the recursive backtracker, or [3] hunt-and-kill? ");
+        if (response >= kruskalChoice && response <= huntAndKillChoice) return response;
+        cout << "Please enter a number between " << kruskalChoice << " and " << huntAndKillChoice << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Prompts the user for the weights that decide the order in which Kruskal's algorithm visits the walls, and returns one of the
+ * weight constants. Uniform weights use the parallel generator; the others use the weighted generator (see maze-headless.h).
+ */
+static int getWallWeights() {
+    while (true) {
+        int response = getInteger("Which wall weights: [0] uniform, [1] long east-west corridors, or [2] a noise field? ");
+        if (response >= uniformWeights && response <= noiseWeights) return response;
+        cout << "Please enter a number between " << uniformWeights << " and " << noiseWeights << ", inclusive." << endl;
     }
 }
 
 /*
- * This method creates a new vector, called "shuffled walls." The method then removes a wall from a random index in
- * a vector passed in from a parameter, and adds it to the end of the new vector. This process continues until the vector
- * passed in from the parameter is empty. The "shuffled" vector is then returned to the calling method.
+ * Prompts the user for the shape of a graph maze, and returns one of the MazeGraphShape values.
  */
+static int getGraphShape() {
+    while (true) {
+        int response = getInteger("Which shape: [0] rectangular, [1] hexagonal, [2] triangular, [3] a disc, or [4] layered? ");
+        if (response >= RECTANGULAR_GRAPH && response <= LAYERED_GRAPH) return response;
+        cout << "Please enter a number between " << RECTANGULAR_GRAPH << " and " << LAYERED_GRAPH << ", inclusive." << endl;
+    }
+}
 
-static Vector<wall> shuffleWalls(Vector<wall> unshuffledWallVector){
-    Vector<wall> shuffledWalls;
-    wall randomWall;
-    int randomOrdering;
-    while ( !unshuffledWallVector.isEmpty() ) {
-        randomOrdering = randomInteger(0, unshuffledWallVector.size() - 1);
-        randomWall = unshuffledWallVector.get(randomOrdering);
-        shuffledWalls.add(randomWall);
-        unshuffledWallVector.remove(randomOrdering);
+/*
+ * Fills mask with the cells of a width-by-height grid that lie inside the ellipse touching all four of its sides, judged by
+ * the centre of each cell.
+ */
+static void makeDiscMask(uint64_t width, uint64_t height, vector<bool> & mask) {
+    mask.assign(width * height, false);
+    for (uint64_t row = 0; row < height; row++) {
+        double y = (row + 0.5) / height * 2 - 1;
+        for (uint64_t col = 0; col < width; col++) {
+            double x = (col + 0.5) / width * 2 - 1;
+            mask[row * width + col] = x * x + y * y <= 1;
+        }
     }
-    return shuffledWalls;
 }
 
 /*
- * This method cycles through a list of walls, and removes the wall from the display if and only if the wall sepearates two
- * distinct cells.
+ * Prompts the user for the fraction of a headless maze's dead ends to braid away, from 0, which leaves the maze perfect, to 1,
+ * which removes them all.
+ */
+static double getBraidFraction() {
+    while (true) {
+        double response = getReal("What fraction of the dead ends should be braided away (0 to keep the maze perfect)? ");
+        if (response >= 0 && response <= 1) return response;
+        cout << "Please enter a number between 0 and 1, inclusive." << endl;
+    }
+}
+
+/*
+ * Prompts the user for the size of each cell of an exported image, in pixels.
+ */
+static int getPixelsPerCell() {
+    while (true) {
+        int response = getInteger("How many pixels wide should each cell be? ");
+        if (response >= kMinPixelsPerCell && response <= kMaxPixelsPerCell) return response;
+        cout << "Please enter a number between " << kMinPixelsPerCell << " and " << kMaxPixelsPerCell << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Returns whether a filename names an image, going by its extension, and if so sets format to the kind of image.
+ */
+static bool isImageFilename(string filename, MazeImageFormat & format) {
+    string lowered = toLowerCase(filename);
+    if (endsWith(lowered, ".png")) {
+        format = PNG_IMAGE;
+        return true;
+    }
+    if (endsWith(lowered, ".pbm")) {
+        format = PBM_IMAGE;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Prompts the user for the number of threads to generate a headless maze with. The parallel generator builds the same maze
+ * from the same seed no matter how many threads it is given, so the answer only changes how long it takes.
+ */
+static int getHeadlessThreads(string prompt) {
+    while (true) {
+        int response = getInteger(prompt);
+        if (response >= 1 && response <= maxHeadlessThreads) return response;
+        cout << "Please enter a number between 1 and "
+             << maxHeadlessThreads << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Prompts the user for one side of the mazes a farm generates, which must be at least minimum and at most maxFarmDimension.
+ * Farms are meant for many small mazes, each of which one thread generates and measures on its own.
+ */
+static int getFarmDimension(string prompt, int minimum) {
+    while (true) {
+        int response = getInteger(prompt);
+        if (response >= minimum && response <= maxFarmDimension) return response;
+        cout << "Please enter a number between " << minimum << " and " << maxFarmDimension << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Prompts the user for a seed, which may be any whole number from 0 up to the largest 64-bit unsigned value. Seeds are read
+ * as text rather than through getInteger so that every seed the program prints or records in a file can be typed back in.
+ */
+static uint64_t getSeed(string prompt) {
+    while (true) {
+        string line = trim(getLine(prompt));
+        if (!line.empty() && isdigit((unsigned char) line[0])) {
+            char *end;
+            errno = 0;
+            unsigned long long response = strtoull(line.c_str(), &end, 10);
+            if (*end == '\0' && errno != ERANGE) return response;
+        }
+        cout << "Please enter a whole number between 0 and " << UINT64_MAX << ", inclusive." << endl;
+    }
+}
+
+/*
+ * Prints the progress reported by a headless generator on a single line of the console, which is rewritten in place until
+ * the phase completes.
+ */
+static void printProgress(const char *phase, double fractionDone) {
+    cout << "\r" << phase << ": " << (int) (fractionDone * 100) << "%" << flush;
+    if (fractionDone >= 1) cout << endl;
+}
+
+/*
+ * This method returns a shuffled vectors of all walls in the current maze to the main method. Nothing is drawn here; see drawFullGrid and
+ * drawFinishedMaze.
  *
- * This is done by keeping track of all 'mergedCells' through a vector of sets of cells. Before every single wall is removed,
- * a check is performed to make sure that the two cells the wall separates aren't included together in any one of the sets included
- * in the 'mergedCells' vector.
+ * Speficially, this method creates an initial wall vector to start. For every possible coordinate pair given the dimensions of the
+ * maze, the walls that bind that cell are added to the initial wall vector.
  *
- * If a wall is removed, this means that either a new cell was formed, a previously unmerged cell joined a merged cell, or that two
- * merged cells have joined. The rest of the method checks each one of these individual cases, and modifies the 'mergedCell' vector appropriately.
- */
-static void removeSeparatingWalls(Vector<wall> wallOrder, MazeGeneratorView & finalWindow, Set<cell> & unmergedCells) {
-    Vector<Set <cell> > mergedCells;
-    bool cellsAreSame;
-    for(int i = wallOrder.size() - 1; i >= 0 ; i--){
-        cellsAreSame = false;
-        cell testCellOne = wallOrder[i].one;
-        cell testCellTwo = wallOrder[i].two;
-        for (int j = 0; j < mergedCells.size(); j++){
-            if (mergedCells[j].contains(testCellOne) && mergedCells[j].contains(testCellTwo)){
-                cellsAreSame = true;
-            }
-        }
-        if (!cellsAreSame) {
-            finalWindow.removeWall(wallOrder[i]);
-            if (unmergedCells.contains(testCellOne) && unmergedCells.contains(testCellTwo)) {
-                createNewMergedCell (mergedCells, unmergedCells, testCellOne, testCellTwo);
-            } else if (!unmergedCells.contains(testCellOne) && unmergedCells.contains(testCellTwo)) {
-                addToMergedCell (mergedCells, unmergedCells, testCellOne, testCellTwo);
-            } else if (unmergedCells.contains(testCellOne) && !unmergedCells.contains(testCellTwo)){
-                addToMergedCell (mergedCells, unmergedCells, testCellTwo, testCellOne);
-            } else {
-                combineTwoMergedCells (mergedCells, testCellOne, testCellTwo);
+ * Once this is all done, the initial wall vector (which now contains every wall in the maze), is shuffled in place using the generator passed in. This
+ * shuffled vector is what is returned to the main method.
+ */
+static Vector<uint32_t> initializeWallsAndChambers(int initialDimensions, MazeRandom & generator){
+    Vector<uint32_t> initialWallVector;
+    {
+        MAZE_TIME_PHASE(INITIALIZE_WALLS_PHASE);
+        for (int i = 0; i < initialDimensions; i++){
+            for (int j = 0; j < initialDimensions; j++){
+                initializeCellWalls(i, j, initialWallVector, initialDimensions);
             }
         }
     }
+    shuffleWalls(initialWallVector, generator);
+    return initialWallVector;
 }
 
 /*
- * This method takes two cells known to be previously unmerged, creates a new 'mergedcell' set from the two of them, and adds it to the master 'merged' cell
- * vector. As both of these cells are now merged, they are removed from the unmerged cell set.
+ * This method checks to see if a cell has space directly east and directly south of it for a new wall. If there is space for it, the
+ * wall's index is added to a vector. Walls are identified the same way as in the headless generators (see makeWallIndex in
+ * maze-bitplanes.h): the index of the cell to their north or west, shifted left once, with the low bit telling which side of that
+ * cell the wall is on. That takes 4 bytes per wall instead of the 16 of a wall struct, and the two cells can be recovered with a
+ * shift and an add.
  */
-static void createNewMergedCell(Vector<Set <cell> > & origMergedCells, Set<cell> & origUnmergedCells, cell unmergedOne, cell unmergedTwo){
-    Set<cell> newMergedCell;
-    origUnmergedCells.remove(unmergedOne);
-    origUnmergedCells.remove(unmergedTwo);
-    newMergedCell.add(unmergedOne);
-    newMergedCell.add(unmergedTwo);
-    origMergedCells.add(newMergedCell);
+static void initializeCellWalls(int cellX, int cellY, Vector<uint32_t> & originalWallVector, int originalDimensions){
+    uint32_t cellIndex = cellX * originalDimensions + cellY;
+    if (cellY + 1 < originalDimensions) originalWallVector.add(makeWallIndex(cellIndex, kEastWall));
+    if (cellX + 1 < originalDimensions) originalWallVector.add(makeWallIndex(cellIndex, kSouthWall));
 }
 
 /*
- * This method takes one cell that is known to be part of a merged cell and one cell that is known to be previously unmerged, and adds the formerly unmerged cell
- * to the appropriate merged cell set in the master merged cell vector. The formerly unmerged cell is removed from the unmerged cell set.
+ * This method shuffles a vector of walls in place with a Fisher-Yates shuffle (see maze-random.h). Every wall is swapped with a
+ * random wall at or before it, starting from the back of the vector, so the whole shuffle takes a single pass and no copies of the
+ * vector are made. The main method seeds the generator from randomInteger, so setRandomSeed still makes a maze reproducible.
  */
-static void addToMergedCell(Vector<Set <cell> > & origMergedCells, Set<cell> & origUnmergedCells, cell mergedCell, cell unmergedCell){
-    for (int i = 0; i < origMergedCells.size(); i++){
-        if (origMergedCells[i].contains(mergedCell)){
-            origMergedCells[i].add(unmergedCell);
-            break;
+static void shuffleWalls(Vector<uint32_t> & wallVector, MazeRandom & generator){
+    MAZE_TIME_PHASE(SHUFFLE_PHASE);
+    if (wallVector.isEmpty()) return;
+    shuffleInPlace(&wallVector[0], wallVector.size(), generator);
+}
+
+/*
+ * This method cycles through a list of walls, and records the wall as removed if and only if the wall sepearates two distinct
+ * cells. The positions (in wallOrder) of the removed walls are added to removalOrder, in the order they came down, so the
+ * removals can be drawn later.
+ *
+ * This is done by keeping track of which cells have been merged into the same chamber through a disjoint-set structure, in
+ * which every cell is identified by its index. The cells on either side of a wall come straight out of the wall's index: the
+ * cell it belongs to, and the cell one to the east or one row down. Every cell starts out as a chamber of its own. Before every
+ * single wall is removed, the structure is asked to merge the chambers on either side of the wall; it refuses if the two cells
+ * already share a chamber, in which case the wall stays up.
+ *
+ * Once dimension * dimension - 1 walls have come down, every cell is in the same chamber and no other wall can be removed, so
+ * the method stops there. It returns how many walls it examined.
+ */
+static int removeSeparatingWalls(const Vector<uint32_t> & wallOrder, int dimension, Vector<int> & removalOrder) {
+    MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+    DisjointSet chambers(dimension * dimension);
+    int wallsToRemove = dimension * dimension - 1;
+    int wallsExamined = 0;
+    for(int i = wallOrder.size() - 1; i >= 0 && removalOrder.size() < wallsToRemove; i--){
+        wallsExamined++;
+        int testCellOne = wallOrder[i] >> 1;
+        int testCellTwo = testCellOne + ((wallOrder[i] & 1) == kEastWall ? 1 : dimension);
+        if (chambers.merge(testCellOne, testCellTwo)) {
+            removalOrder.add(i);
         }
     }
-    origUnmergedCells.remove(unmergedCell);
+    MAZE_COUNT(WALLS_EXAMINED, wallsExamined);
+    MAZE_COUNT(WALLS_REMOVED, removalOrder.size());
+    return wallsExamined;
 }
+
 /*
- * This method takes in two cells that are known to be part of a merged cell (but not the same merged cell), and combines the two sets that each individual
- * cell was a part of. Any duplication (multiple instances of the same cell in the master merged cell vector) that results from this is deleted at the end
- * of the method.
+ * This method draws the border and every wall of a maze before any wall has come down, then repaints the window once, so the
+ * whole grid shows up as a single frame instead of one wall at a time.
  */
-static void combineTwoMergedCells(Vector<Set <cell> > & origMergedCells, cell mergedOne, cell mergedTwo){
-    int addressToSend;
-    int addressToEvict;
-    for (int i = 0; i < origMergedCells.size(); i++){
-        if (origMergedCells[i].contains(mergedOne)){
-            addressToSend = i;
-        }
-        if (origMergedCells[i].contains(mergedTwo)){
-            addressToEvict = i;
+static void drawFullGrid(MazeGeneratorView & mazeWindow, const Vector<uint32_t> & wallOrder, int dimension) {
+    MAZE_TIME_PHASE(DRAW_PHASE);
+    mazeWindow.drawBorder();
+    MAZE_COUNT(DRAW_CALLS, 1);
+    for (uint32_t wallIndex : wallOrder) {
+        mazeWindow.drawWall(indexToWall(wallIndex, dimension));
+        MAZE_COUNT(DRAW_CALLS, 1);
+    }
+    mazeWindow.repaint();
+    MAZE_COUNT(REPAINTS, 1);
+}
+
+/*
+ * This method moves a replay cursor to targetStep a frame at a time, taking walls down when moving forward and putting them
+ * back up when moving back: wallsPerFrame steps are coalesced into each frame, the window is repainted once per frame, and
+ * the method pauses long enough to show framesPerSecond frames each second. A framesPerSecond of 0 moves straight to the
+ * target and repaints once. The maze itself was finished before the animation started, so the animation can be as slow as
+ * the user likes. Only the drawing counts toward the draw phase, not the pauses between frames.
+ */
+static void animateWallRemovals(MazeGeneratorView & mazeWindow, MazeReplayCursor & cursor, int dimension, uint64_t targetStep,
+                                int framesPerSecond, int wallsPerFrame) {
+    while (cursor.position() != targetStep) {
+        {
+            MAZE_TIME_PHASE(DRAW_PHASE);
+            for (int i = 0; i < wallsPerFrame && cursor.position() != targetStep; i++) {
+                uint64_t wallIndex;
+                if (cursor.position() < targetStep) {
+                    cursor.stepForward(wallIndex);
+                    mazeWindow.removeWall(indexToWall(wallIndex, dimension));
+                } else {
+                    cursor.stepBack(wallIndex);
+                    mazeWindow.drawWall(indexToWall(wallIndex, dimension));
+                }
+                MAZE_COUNT(DRAW_CALLS, 1);
+            }
+            if (framesPerSecond == 0) continue;
+            mazeWindow.repaint();
+            MAZE_COUNT(REPAINTS, 1);
         }
+        pause(1000.0 / framesPerSecond);
+    }
+    if (framesPerSecond == 0) {
+        MAZE_TIME_PHASE(DRAW_PHASE);
+        mazeWindow.repaint();
+        MAZE_COUNT(REPAINTS, 1);
+    }
+}
+
+/*
+ * This method draws a finished maze without animating it. Only the border and the walls left standing are drawn, which is
+ * fewer calls than drawing every wall and then taking most of them back down, and the window is repainted once at the end.
+ */
+static void drawFinishedMaze(MazeGeneratorView & mazeWindow, const Vector<uint32_t> & wallOrder, int dimension,
+                             const Vector<int> & removalOrder) {
+    Vector<bool> isRemoved(wallOrder.size(), false);
+    for (int index : removalOrder) {
+        isRemoved[index] = true;
+    }
+    MAZE_TIME_PHASE(DRAW_PHASE);
+    mazeWindow.drawBorder();
+    MAZE_COUNT(DRAW_CALLS, 1);
+    for (int i = 0; i < wallOrder.size(); i++) {
+        if (isRemoved[i]) continue;
+        mazeWindow.drawWall(indexToWall(wallOrder[i], dimension));
+        MAZE_COUNT(DRAW_CALLS, 1);
     }
-    origMergedCells[addressToSend] += origMergedCells[addressToEvict];
-    origMergedCells.remove(addressToEvict);
+    mazeWindow.repaint();
+    MAZE_COUNT(REPAINTS, 1);
 }
 
+/*
+ * This method turns a wall index back into the wall struct the MazeGeneratorView draws. Cells are numbered row by row, starting
+ * from 0 in the top left corner, and a wall lies between the cell its index names and the cell to the east or south of it.
+ */
+static wall indexToWall(uint32_t wallIndex, int dimension) {
+    int cellIndex = wallIndex >> 1;
+    wall mazeWall;
+    mazeWall.one.row = cellIndex / dimension;
+    mazeWall.one.col = cellIndex % dimension;
+    mazeWall.two = mazeWall.one;
+    if ((wallIndex & 1) == kEastWall) {
+        mazeWall.two.col++;
+    } else {
+        mazeWall.two.row++;
+    }
+    return mazeWall;
+}
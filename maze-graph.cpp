@@ -0,0 +1,297 @@
+/**
+ * File: maze-graph.cpp
+ * --------------------
+ * Implements the graph builders and generators declared in maze-graph.h.
+ */
+
+#include <algorithm>
+using namespace std;
+
+#include "maze-graph.h"
+#include "maze-disjoint-set.h"
+#include "maze-random.h"
+#include "maze-headless.h"
+
+//Prototypes
+static void buildGraph(MazeGraphShape shape, uint64_t width, uint64_t height, uint64_t layers, const vector<bool> *mask,
+                       mazeGraph & graph);
+static int listNeighbourPositions(const mazeGraph & graph, uint64_t position, uint64_t neighbourPositions[]);
+static uint64_t delegateRectangularWilsonMaze(const mazeGraph & graph, uint64_t seed, vector<uint64_t> & passages);
+static void plantRoots(const mazeGraph & graph, MazeRandom & generator, vector<uint64_t> & inTree);
+static bool isInTree(const vector<uint64_t> & inTree, uint64_t cell);
+static void addToTree(vector<uint64_t> & inTree, uint64_t cell);
+static uint64_t packEdge(uint64_t one, uint64_t two);
+static const int maxNeighbours = 6;
+static const int slotBits[maxNeighbours + 1] = { 0, 0, 1, 2, 2, 3, 3 };
+
+void buildRectangularGraph(uint64_t width, uint64_t height, mazeGraph & graph) {
+    buildGraph(RECTANGULAR_GRAPH, width, height, 1, NULL, graph);
+}
+
+void buildHexagonalGraph(uint64_t width, uint64_t height, mazeGraph & graph) {
+    buildGraph(HEXAGONAL_GRAPH, width, height, 1, NULL, graph);
+}
+
+void buildTriangularGraph(uint64_t width, uint64_t height, mazeGraph & graph) {
+    buildGraph(TRIANGULAR_GRAPH, width, height, 1, NULL, graph);
+}
+
+void buildMaskedGraph(uint64_t width, uint64_t height, const vector<bool> & mask, mazeGraph & graph) {
+    buildGraph(MASKED_GRAPH, width, height, 1, &mask, graph);
+}
+
+void buildLayeredGraph(uint64_t width, uint64_t height, uint64_t layers, mazeGraph & graph) {
+    buildGraph(LAYERED_GRAPH, width, height, layers, NULL, graph);
+}
+
+/*
+ * The edges are copied and shuffled with the same generator as generateKruskalMaze, then visited in order. Each edge already
+ * holds both of its cells, so visiting it takes no arithmetic and no lookups in the graph. A graph in one piece is finished
+ * once numCells - 1 passages are carved; a graph in several pieces has every edge visited.
+ */
+uint64_t generateGraphKruskalMaze(const mazeGraph & graph, uint64_t seed, vector<uint64_t> & passages,
+                                  uint64_t & edgesExamined) {
+    passages.clear();
+    edgesExamined = 0;
+    if (graph.numCells == 0) return 0;
+    vector<uint64_t> order(graph.edges);
+    MazeRandom generator(seed);
+    if (!order.empty()) shuffleInPlace(&order[0], order.size(), generator);
+
+    DisjointSet chambers(graph.numCells);
+    uint64_t treeSize = graph.numCells - 1;
+    passages.reserve(treeSize);
+    while (passages.size() < treeSize && edgesExamined < order.size()) {
+        uint64_t edge = order[edgesExamined++];
+        if (chambers.merge(edge >> 32, edge & 0xffffffff)) passages.push_back(edge);
+    }
+    return passages.size();
+}
+
+/*
+ * As in generateWilsonMaze, a walk records for every cell it passes through which way it last left that cell, here as the
+ * position of the neighbour in the cell's row of the CSR arrays, and walking over a cell again overwrites it, which erases the
+ * loop. Each piece of the graph needs a root for walks to end at; see plantRoots. A neighbour is picked by taking just enough
+ * bits from a random word to number them all, and taking more if the number is too big, so every neighbour is equally likely
+ * and most steps cost a shift and a mask. A rectangular graph does not use this walk at all: it is handed to
+ * generateWilsonMaze instead; see delegateRectangularWilsonMaze.
+ */
+uint64_t generateGraphWilsonMaze(const mazeGraph & graph, uint64_t seed, vector<uint64_t> & passages) {
+    passages.clear();
+    if (graph.numCells == 0) return 0;
+    if (graph.shape == RECTANGULAR_GRAPH) return delegateRectangularWilsonMaze(graph, seed, passages);
+    vector<uint64_t> inTree((graph.numCells + 63) / 64, 0);
+    vector<uint8_t> exits(graph.numCells);
+    MazeRandom generator(seed);
+    plantRoots(graph, generator, inTree);
+
+    uint64_t randomBits = 0;
+    int bitsLeft = 0;
+    for (uint64_t start = 0; start < graph.numCells; start++) {
+        if (isInTree(inTree, start)) continue;
+        uint64_t current = start;
+        while (!isInTree(inTree, current)) {
+            uint32_t first = graph.firstNeighbour[current];
+            uint32_t degree = graph.firstNeighbour[current + 1] - first;
+            int numBits = slotBits[degree];
+            uint32_t slot;
+            do {
+                if (bitsLeft < numBits) {
+                    randomBits = generator.next();
+                    bitsLeft = 64;
+                }
+                slot = randomBits & ((1 << numBits) - 1);
+                randomBits >>= numBits;
+                bitsLeft -= numBits;
+            } while (slot >= degree);
+            exits[current] = slot;
+            current = graph.neighbours[first + slot];
+        }
+        current = start;
+        while (!isInTree(inTree, current)) {
+            addToTree(inTree, current);
+            uint64_t next = graph.neighbours[graph.firstNeighbour[current] + exits[current]];
+            passages.push_back(packEdge(current, next));
+            current = next;
+        }
+    }
+    return passages.size();
+}
+
+bool graphMazeToBitplanes(const mazeGraph & graph, const vector<uint64_t> & passages, MazeBitplanes & maze) {
+    if (graph.shape != RECTANGULAR_GRAPH && graph.shape != MASKED_GRAPH) return false;
+    maze.resize(graph.width, graph.height);
+    for (uint64_t passage : passages) {
+        uint64_t one = graph.positionOf[passage >> 32];
+        uint64_t two = graph.positionOf[passage & 0xffffffff];
+        uint64_t position = min(one, two);
+        if (max(one, two) / graph.width == position / graph.width) {
+            maze.removeEastWall(position / graph.width, position % graph.width);
+        } else {
+            maze.removeSouthWall(position / graph.width, position % graph.width);
+        }
+    }
+    return true;
+}
+
+uint64_t graphMemoryEstimate(const mazeGraph & graph) {
+    return (graph.firstNeighbour.size() + graph.neighbours.size() + graph.cellAt.size() + graph.positionOf.size())
+           * sizeof(uint32_t) + graph.edges.size() * sizeof(uint64_t);
+}
+
+/*
+ * This method builds every kind of graph. Positions are visited a tile at a time, and every position that holds a cell is
+ * given the next cell number. Then, cell by cell, the positions of its neighbours are listed and the cells there appended to
+ * the CSR arrays, and each pair of neighbours is added to the edges from the side of the lower-numbered cell.
+ */
+static void buildGraph(MazeGraphShape shape, uint64_t width, uint64_t height, uint64_t layers, const vector<bool> *mask,
+                       mazeGraph & graph) {
+    graph.shape = shape;
+    graph.width = width;
+    graph.height = height;
+    graph.layers = layers;
+    graph.cellAt.assign(layers * height * width, kNoGraphCell);
+    graph.positionOf.clear();
+    for (uint64_t layer = 0; layer < layers; layer++) {
+        for (uint64_t tileRow = 0; tileRow < height; tileRow += kGraphTileSize) {
+            for (uint64_t tileCol = 0; tileCol < width; tileCol += kGraphTileSize) {
+                for (uint64_t row = tileRow; row < min(height, tileRow + kGraphTileSize); row++) {
+                    for (uint64_t col = tileCol; col < min(width, tileCol + kGraphTileSize); col++) {
+                        if (mask != NULL && !(*mask)[row * width + col]) continue;
+                        uint64_t position = (layer * height + row) * width + col;
+                        graph.cellAt[position] = graph.positionOf.size();
+                        graph.positionOf.push_back(position);
+                    }
+                }
+            }
+        }
+    }
+    graph.numCells = graph.positionOf.size();
+
+    graph.firstNeighbour.assign(graph.numCells + 1, 0);
+    graph.neighbours.clear();
+    graph.edges.clear();
+    for (uint64_t cell = 0; cell < graph.numCells; cell++) {
+        uint64_t neighbourPositions[maxNeighbours];
+        int numNeighbours = listNeighbourPositions(graph, graph.positionOf[cell], neighbourPositions);
+        for (int i = 0; i < numNeighbours; i++) {
+            uint32_t neighbour = graph.cellAt[neighbourPositions[i]];
+            if (neighbour == kNoGraphCell) continue;
+            graph.neighbours.push_back(neighbour);
+            if (neighbour > cell) graph.edges.push_back(packEdge(cell, neighbour));
+        }
+        graph.firstNeighbour[cell + 1] = graph.neighbours.size();
+    }
+}
+
+/*
+ * This method fills neighbourPositions with the positions next to the given one, by the rules of the graph's shape, and
+ * returns how many there are. Positions off the edge of the grid are left out; positions with no cell are not.
+ */
+static int listNeighbourPositions(const mazeGraph & graph, uint64_t position, uint64_t neighbourPositions[]) {
+    uint64_t width = graph.width;
+    uint64_t col = position % width;
+    uint64_t row = position / width % graph.height;
+    uint64_t layer = position / width / graph.height;
+    bool hasEast = col + 1 < width;
+    bool hasSouth = row + 1 < graph.height;
+    int count = 0;
+    if (hasEast) neighbourPositions[count++] = position + 1;
+    if (col > 0) neighbourPositions[count++] = position - 1;
+    if (graph.shape == TRIANGULAR_GRAPH) {
+        bool pointsUp = (row + col) % 2 == 0;
+        if (pointsUp && hasSouth) neighbourPositions[count++] = position + width;
+        if (!pointsUp && row > 0) neighbourPositions[count++] = position - width;
+    } else if (graph.shape == HEXAGONAL_GRAPH) {
+        bool westAvailable = row % 2 == 1 || col > 0;
+        bool eastAvailable = row % 2 == 0 || hasEast;
+        uint64_t westCol = row % 2 == 0 ? col - 1 : col;
+        uint64_t eastCol = row % 2 == 0 ? col : col + 1;
+        if (row > 0 && westAvailable) neighbourPositions[count++] = position - col - width + westCol;
+        if (row > 0 && eastAvailable) neighbourPositions[count++] = position - col - width + eastCol;
+        if (hasSouth && westAvailable) neighbourPositions[count++] = position - col + width + westCol;
+        if (hasSouth && eastAvailable) neighbourPositions[count++] = position - col + width + eastCol;
+    } else {
+        if (hasSouth) neighbourPositions[count++] = position + width;
+        if (row > 0) neighbourPositions[count++] = position - width;
+        if (graph.shape == LAYERED_GRAPH) {
+            if (layer + 1 < graph.layers) neighbourPositions[count++] = position + width * graph.height;
+            if (layer > 0) neighbourPositions[count++] = position - width * graph.height;
+        }
+    }
+    return count;
+}
+
+/*
+ * This method is generateGraphWilsonMaze for a rectangular graph. It does not walk the CSR arrays: the maze is generated by
+ * generateWilsonMaze on MazeBitplanes of the same size, and every wall left open is then listed as a passage, row by row,
+ * with its positions turned into cell numbers through cellAt. The passages therefore come out in row order rather than in
+ * the order they were carved.
+ */
+static uint64_t delegateRectangularWilsonMaze(const mazeGraph & graph, uint64_t seed, vector<uint64_t> & passages) {
+    MazeBitplanes maze(graph.width, graph.height);
+    generateWilsonMaze(maze, seed, NULL);
+    passages.reserve(graph.numCells - 1);
+    for (uint64_t row = 0; row < graph.height; row++) {
+        for (uint64_t col = 0; col < graph.width; col++) {
+            uint64_t position = row * graph.width + col;
+            if (col + 1 < graph.width && !maze.hasEastWall(row, col)) {
+                passages.push_back(packEdge(graph.cellAt[position], graph.cellAt[position + 1]));
+            }
+            if (row + 1 < graph.height && !maze.hasSouthWall(row, col)) {
+                passages.push_back(packEdge(graph.cellAt[position], graph.cellAt[position + graph.width]));
+            }
+        }
+    }
+    return passages.size();
+}
+
+/*
+ * This method puts one root into every piece of the graph, so that every walk has somewhere to end. The first root is a random
+ * cell. Every cell that can be reached from a root is found with a breadth-first search, and the first cell no search has
+ * reached becomes the next root, until every cell has been reached. Wilson's algorithm picks every spanning tree with equal
+ * odds whatever the root, so only the first root needs to be random.
+ */
+static void plantRoots(const mazeGraph & graph, MazeRandom & generator, vector<uint64_t> & inTree) {
+    vector<uint64_t> reached((graph.numCells + 63) / 64, 0);
+    vector<uint32_t> queue;
+    uint64_t root = generator.nextBelow(graph.numCells);
+    uint64_t nextUnreached = 0;
+    while (true) {
+        addToTree(inTree, root);
+        addToTree(reached, root);
+        queue.assign(1, root);
+        for (size_t i = 0; i < queue.size(); i++) {
+            for (uint32_t j = graph.firstNeighbour[queue[i]]; j < graph.firstNeighbour[queue[i] + 1]; j++) {
+                uint32_t neighbour = graph.neighbours[j];
+                if (isInTree(reached, neighbour)) continue;
+                addToTree(reached, neighbour);
+                queue.push_back(neighbour);
+            }
+        }
+        while (nextUnreached < graph.numCells && isInTree(reached, nextUnreached)) nextUnreached++;
+        if (nextUnreached == graph.numCells) break;
+        root = nextUnreached;
+    }
+}
+
+/*
+ * This method returns whether a cell's bit is set in a bitset with one bit per cell.
+ */
+static bool isInTree(const vector<uint64_t> & inTree, uint64_t cell) {
+    return (inTree[cell / 64] >> (cell % 64)) & 1;
+}
+
+/*
+ * This method sets a cell's bit in a bitset with one bit per cell.
+ */
+static void addToTree(vector<uint64_t> & inTree, uint64_t cell) {
+    inTree[cell / 64] |= 1ULL << (cell % 64);
+}
+
+/*
+ * This method packs two neighbouring cells into an edge, lower-numbered cell first.
+ */
+static uint64_t packEdge(uint64_t one, uint64_t two) {
+    return one < two ? (one << 32) | two : (two << 32) | one;
+}
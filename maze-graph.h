@@ -0,0 +1,158 @@
+/**
+ * File: maze-graph.h
+ * ------------------
+ * Declares a maze engine that works on any graph of cells, not just a square
+ * grid. The graph is stored in compressed sparse row (CSR) form, and a maze is
+ * a spanning tree of it: the list of passages carved between neighbouring
+ * cells. Builders are provided for rectangular, hexagonal, triangular,
+ * masked and layered grids.
+ */
+
+#ifndef _maze_graph_
+#define _maze_graph_
+
+#include <cstdint>
+#include <vector>
+#include "maze-bitplanes.h"
+
+/*
+ * Type: MazeGraphShape
+ * --------------------
+ * The kinds of grid the builders can lay cells out on.
+ */
+enum MazeGraphShape {
+    RECTANGULAR_GRAPH,
+    HEXAGONAL_GRAPH,
+    TRIANGULAR_GRAPH,
+    MASKED_GRAPH,
+    LAYERED_GRAPH
+};
+
+/*
+ * Constants: kNoGraphCell, kGraphTileSize
+ * ---------------------------------------
+ * kNoGraphCell marks a position of the grid that holds no cell, and
+ * kGraphTileSize is the side of the tiles cells are numbered in (see
+ * mazeGraph).
+ */
+static const uint32_t kNoGraphCell = 0xffffffff;
+static const int kGraphTileSize = 16;
+
+/*
+ * Type: mazeGraph
+ * ---------------
+ * A graph of cells laid out on a grid of layers * height * width positions,
+ * where position (layer * height + row) * width + col is at the given layer,
+ * row and column.
+ *
+ * Cells are numbered from 0 to numCells - 1. The neighbours of cell c are
+ * neighbours[firstNeighbour[c]] up to neighbours[firstNeighbour[c + 1] - 1].
+ * Every pair of neighbours also appears once in edges, packed as
+ * (lowerCell << 32) | higherCell; the walls of the maze are exactly these
+ * edges. cellAt and positionOf translate between cells and grid positions.
+ *
+ * Cells are numbered in tiles of kGraphTileSize x kGraphTileSize positions
+ * rather than row by row, so that a cell and the neighbours above and below
+ * it usually sit in the same few cache lines of every per-cell array.
+ * Cells, positions and neighbour entries must each number fewer than 2^32.
+ */
+struct mazeGraph {
+    MazeGraphShape shape;
+    uint64_t width;
+    uint64_t height;
+    uint64_t layers;
+    uint64_t numCells;
+    std::vector<uint32_t> firstNeighbour;
+    std::vector<uint32_t> neighbours;
+    std::vector<uint64_t> edges;
+    std::vector<uint32_t> cellAt;
+    std::vector<uint32_t> positionOf;
+};
+
+/*
+ * Functions: buildRectangularGraph, buildHexagonalGraph, buildTriangularGraph
+ * Usage: buildHexagonalGraph(width, height, graph);
+ * -------------------------------------------------
+ * Fill graph with a width-by-height grid of cells. Rectangular cells have up
+ * to four neighbours: east, south, west and north. Hexagonal cells have up to
+ * six, with every odd row shifted half a cell to the east. Triangular cells
+ * have up to three: the triangle in row r and column c points up when r + c
+ * is even and shares its base with the triangle below, and points down
+ * otherwise and shares its base with the triangle above.
+ */
+void buildRectangularGraph(uint64_t width, uint64_t height, mazeGraph & graph);
+void buildHexagonalGraph(uint64_t width, uint64_t height, mazeGraph & graph);
+void buildTriangularGraph(uint64_t width, uint64_t height, mazeGraph & graph);
+
+/*
+ * Function: buildMaskedGraph
+ * Usage: buildMaskedGraph(width, height, mask, graph);
+ * ----------------------------------------------------
+ * Fills graph with the rectangular cells of a width-by-height grid whose
+ * entry in mask, indexed by row * width + col, is true. Cells the mask leaves
+ * out are holes in the maze. If the cells that remain fall into several
+ * separate pieces, each piece becomes a maze of its own.
+ */
+void buildMaskedGraph(uint64_t width, uint64_t height, const std::vector<bool> & mask, mazeGraph & graph);
+
+/*
+ * Function: buildLayeredGraph
+ * Usage: buildLayeredGraph(width, height, layers, graph);
+ * -------------------------------------------------------
+ * Fills graph with a stack of rectangular width-by-height grids, in which
+ * every cell is also a neighbour of the cells directly above and below it in
+ * the layers on either side.
+ */
+void buildLayeredGraph(uint64_t width, uint64_t height, uint64_t layers, mazeGraph & graph);
+
+/*
+ * Function: generateGraphKruskalMaze
+ * Usage: uint64_t carved = generateGraphKruskalMaze(graph, seed, passages, edgesExamined);
+ * ----------------------------------------------------------------------------------------
+ * Carves a maze through graph with the same adaptation of Kruskal's algorithm
+ * as generateKruskalMaze (see maze-headless.h): the edges are shuffled, and
+ * each one becomes a passage if and only if it joins two separate chambers.
+ * passages is filled with the passages in the order they were carved, packed
+ * like the entries of graph.edges. Returns the number of passages and sets
+ * edgesExamined to the number of edges visited.
+ */
+uint64_t generateGraphKruskalMaze(const mazeGraph & graph, uint64_t seed, std::vector<uint64_t> & passages,
+                                  uint64_t & edgesExamined);
+
+/*
+ * Function: generateGraphWilsonMaze
+ * Usage: uint64_t carved = generateGraphWilsonMaze(graph, seed, passages);
+ * ------------------------------------------------------------------------
+ * Carves a maze through graph with Wilson's algorithm (see
+ * generateWilsonMaze in maze-headless.h), so every spanning tree of the graph
+ * is equally likely. passages is filled as for generateGraphKruskalMaze.
+ * Returns the number of passages.
+ *
+ * A rectangular graph is not walked through the CSR arrays: it is handed to
+ * generateWilsonMaze, and its passages are listed row by row afterwards
+ * rather than in the order they were carved. Every other shape uses the CSR
+ * walk, which takes about 1.7 to 2 times as long as generateWilsonMaze on a
+ * grid of 4000x4000 cells, since its arrays are far too big for the cache.
+ */
+uint64_t generateGraphWilsonMaze(const mazeGraph & graph, uint64_t seed, std::vector<uint64_t> & passages);
+
+/*
+ * Function: graphMazeToBitplanes
+ * Usage: if (graphMazeToBitplanes(graph, passages, maze)) ...
+ * -----------------------------------------------------------
+ * Turns a maze carved through a rectangular or masked graph into
+ * MazeBitplanes of the same size, so it can be saved, solved, measured and
+ * drawn like any other. The holes of a masked graph keep all four walls.
+ * Returns false, leaving maze alone, for any other shape of graph.
+ */
+bool graphMazeToBitplanes(const mazeGraph & graph, const std::vector<uint64_t> & passages, MazeBitplanes & maze);
+
+/*
+ * Function: graphMemoryEstimate
+ * Usage: uint64_t bytes = graphMemoryEstimate(graph);
+ * ---------------------------------------------------
+ * Returns roughly how many bytes a graph takes up.
+ */
+uint64_t graphMemoryEstimate(const mazeGraph & graph);
+
+#endif
@@ -0,0 +1,1242 @@
+/**
+ * File: maze-headless.cpp
+ * -----------------------
+ * Implements the maze generators that run without a MazeGeneratorView.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "maze-headless.h"
+#include "maze-disjoint-set.h"
+#include "maze-instrumentation.h"
+#include "maze-random.h"
+
+/*
+ * Type: weightedWall
+ * ------------------
+ * A wall paired with the random weight that decides when the parallel generator considers it. Walls with equal weights are
+ * ordered by index, so the order never depends on how the walls were listed.
+ */
+struct weightedWall {
+    uint64_t weight;
+    uint64_t wallIndex;
+};
+
+/*
+ * Type: stripLink
+ * ---------------
+ * An edge of the graph the parallel generator merges: either a path of one strip's tree between two of its key cells (see
+ * compressStripTree), or a wall between two strips. one and two are the keys at its ends, wall is the path's heaviest wall (or
+ * the wall between the strips), and joinsStrips tells the two kinds apart.
+ */
+struct stripLink {
+    weightedWall wall;
+    uint64_t one;
+    uint64_t two;
+    bool joinsStrips;
+};
+
+/*
+ * Type: mazeStrip
+ * ---------------
+ * The rows firstRow up to (but not including) endRow, as handled by one thread of the parallel generator. Once the strip's
+ * tree is built, numKeys is the number of key cells it was shrunk to, links holds the paths between them, and boundaryWalls the
+ * walls between its last row and the next strip, in column order. wallsExamined counts the walls the strip's own Kruskal pass
+ * looked at.
+ */
+struct mazeStrip {
+    uint64_t firstRow;
+    uint64_t endRow;
+    uint64_t wallsExamined;
+    uint64_t numKeys;
+    vector<stripLink> links;
+    vector<weightedWall> boundaryWalls;
+};
+
+/*
+ * Type: ellerRow
+ * --------------
+ * Everything Eller's algorithm keeps while building a row, all of it sized by the width of the maze. Every cell of the row
+ * belongs to a set, named by an id below the width, and cells share a set when they are already connected. parent joins sets
+ * within the row; carriedDown, candidate and unopenedCells track how each set continues into the next row.
+ */
+struct ellerRow {
+    vector<uint32_t> setOf;
+    vector<uint32_t> parent;
+    vector<uint32_t> candidate;
+    vector<uint32_t> unopenedCells;
+    vector<char> carriedDown;
+    vector<char> inUse;
+    vector<uint64_t> eastWords;
+    vector<uint64_t> southWords;
+};
+
+/*
+ * Class: CoinFlipper
+ * ------------------
+ * Hands out fair coin flips one bit at a time from a MazeRandom, so that 64 flips cost a single call to the generator.
+ */
+class CoinFlipper {
+public:
+    explicit CoinFlipper(MazeRandom & generator) : source(generator), bits(0), bitsLeft(0) {}
+    bool flip() {
+        if (bitsLeft == 0) {
+            bits = source.next();
+            bitsLeft = 64;
+        }
+        bool result = bits & 1;
+        bits >>= 1;
+        bitsLeft--;
+        return result;
+    }
+
+private:
+    MazeRandom & source;
+    uint64_t bits;
+    int bitsLeft;
+};
+
+//Prototypes
+static void joinRowHorizontally(ellerRow & current, uint64_t width, bool isLastRow, CoinFlipper & coins);
+static void carryRowDown(ellerRow & current, uint64_t width, MazeRandom & generator, CoinFlipper & coins);
+static void startNextRow(ellerRow & current, uint64_t width);
+static uint32_t findRowSet(ellerRow & current, uint32_t setId);
+static uint64_t findCellOutsideTree(const vector<uint64_t> & inTree, const RowMajorCellOrder & order, uint64_t numCells,
+                                    uint64_t & searchWord);
+static uint64_t findCellOutsideTree(const vector<uint64_t> & inTree, const MortonCellOrder & order, uint64_t numCells,
+                                    uint64_t & searchCell);
+static unsigned neighbourMask(const vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t width, uint64_t height,
+                              uint64_t row, uint64_t col, bool wantVisited);
+static int pickDirection(unsigned choices, MazeRandom & generator, uint64_t & randomBits, int & bitsLeft);
+static void carvePassage(MazeBitplanes & maze, uint64_t row, uint64_t col, int direction);
+static void markVisited(vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t row, uint64_t col);
+static void findHuntedCell(const vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t width, uint64_t height,
+                           uint64_t topRow, uint64_t & huntWord, uint64_t & row, uint64_t & col);
+static uint64_t rowWordMask(uint64_t wordInRow, uint64_t wordsPerRow, uint64_t width);
+static bool operator<(const weightedWall & one, const weightedWall & two);
+static bool operator<(const stripLink & one, const stripLink & two);
+static void buildStripTree(MazeBitplanes & maze, mazeStrip & strip, uint64_t seed);
+static void compressStripTree(const MazeBitplanes & maze, mazeStrip & strip, uint64_t seed);
+static int findStripNeighbours(const MazeBitplanes & maze, const mazeStrip & strip, uint64_t cell, uint64_t neighbours[]);
+static weightedWall stripWallBetween(const MazeBitplanes & maze, const mazeStrip & strip, uint64_t seed, uint64_t one,
+                                     uint64_t two);
+static void restoreWall(MazeBitplanes & maze, uint64_t wallIndex);
+static uint64_t mergeStripTrees(MazeBitplanes & maze, const vector<mazeStrip> & strips, uint64_t & wallsExamined,
+                                MazeProgressFn progress);
+static uint64_t countInteriorWalls(uint64_t width, uint64_t height);
+template <typename CellOrder>
+static uint64_t removeShuffledWalls(MazeBitplanes & maze, const vector<uint64_t> & walls, DisjointSet & chambers,
+                                    const CellOrder & order, uint64_t & wallsExamined, MazeProgressFn progress);
+template <typename CellOrder>
+static uint64_t growWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress, const CellOrder & order);
+static void listInteriorWalls(const MazeBitplanes & maze, vector<uint64_t> & walls, MazeProgressFn progress);
+static void reportProgress(MazeProgressFn progress, const char *phase, uint64_t done, uint64_t total);
+static void computeWallWeights(const MazeBitplanes & maze, uint64_t seed, MazeWeightFn weightOf, int numThreads,
+                               vector<uint32_t> & weights, vector<uint64_t> & walls);
+static void radixSortWalls(vector<uint32_t> & weights, vector<uint64_t> & walls, int numThreads);
+static void runInSlices(int numSlices, uint64_t count, const function<void(int, uint64_t, uint64_t)> & work);
+static uint32_t noiseAt(uint64_t seed, uint64_t gridRow, uint64_t gridCol);
+static const int radixBits = 8;
+static const int radixBuckets = 1 << radixBits;
+static const uint64_t noiseSpacing = 32;
+static const uint64_t noiseSalt = 0x6e6f697365ULL;
+static const uint64_t progressSteps = 100;
+static const uint64_t concurrentBlockSize = 4096;
+static const int rowStep[4] = { 0, 1, 0, -1 };
+static const int colStep[4] = { 1, 0, -1, 0 };
+
+uint64_t generateKruskalMaze(MazeBitplanes & maze, uint64_t seed, uint64_t & wallsExamined, MazeProgressFn progress) {
+    kruskalScratch scratch;
+    return generateKruskalMaze(maze, seed, wallsExamined, progress, scratch, ROW_MAJOR_LAYOUT);
+}
+
+/*
+ * The walls are listed by index, shuffled in place, and then visited in order. For every wall the disjoint-set
+ * structure is asked to merge the two cells on either side of it; the wall is knocked down only when that merge
+ * succeeds, which is exactly when the two cells were in different chambers. A spanning tree of n cells has n - 1
+ * edges, so once that many walls are down every cell is in one chamber and the remaining walls are left unvisited.
+ * The layout only decides which element of the disjoint-set structure stands for each cell, so it never changes the maze.
+ */
+uint64_t generateKruskalMaze(MazeBitplanes & maze, uint64_t seed, uint64_t & wallsExamined, MazeProgressFn progress,
+                             kruskalScratch & scratch, MazeCellLayout layout) {
+    wallsExamined = 0;
+    if (maze.numCells() == 0) return 0;
+    vector<uint64_t> & walls = scratch.walls;
+    listInteriorWalls(maze, walls, progress);
+
+    MazeRandom generator(seed);
+    reportProgress(progress, "Shuffling walls", 0, 1);
+    {
+        MAZE_TIME_PHASE(SHUFFLE_PHASE);
+        if (!walls.empty()) shuffleInPlace(&walls[0], walls.size(), generator);
+    }
+    reportProgress(progress, "Shuffling walls", 1, 1);
+
+    if (layout == MORTON_LAYOUT) {
+        return removeShuffledWalls(maze, walls, scratch.chambers, MortonCellOrder(maze.width(), maze.height()),
+                                   wallsExamined, progress);
+    }
+    return removeShuffledWalls(maze, walls, scratch.chambers, RowMajorCellOrder(maze.width(), maze.height()),
+                               wallsExamined, progress);
+}
+
+/*
+ * The strips are handed one to a thread. The weight of every wall is uniformWallWeight(seed, wallIndex), so it does not matter
+ * which thread computes it or when, and the weights, and with them the maze, depend only on the seed. Every strip removes the
+ * walls of its own tree straight from the maze; the strips own different rows, and every row has words of its own, so no two
+ * threads ever touch the same word. Once every thread is done, the strips are merged on this thread. A single strip's tree is
+ * already the whole maze, so it needs no merge.
+ */
+uint64_t generateParallelKruskalMaze(MazeBitplanes & maze, uint64_t seed, int numThreads, uint64_t & wallsExamined,
+                                     MazeProgressFn progress) {
+    wallsExamined = 0;
+    if (maze.numCells() == 0) return 0;
+    uint64_t numStrips = min<uint64_t>(max(numThreads, 1), maze.height());
+    vector<mazeStrip> strips(numStrips);
+    vector<thread> workers;
+    reportProgress(progress, "Building strips", 0, 1);
+    for (uint64_t i = 0; i < numStrips; i++) {
+        strips[i].firstRow = maze.height() * i / numStrips;
+        strips[i].endRow = maze.height() * (i + 1) / numStrips;
+        workers.push_back(thread(buildStripTree, ref(maze), ref(strips[i]), seed));
+    }
+    for (uint64_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    reportProgress(progress, "Building strips", 1, 1);
+    for (uint64_t i = 0; i < numStrips; i++) {
+        wallsExamined += strips[i].wallsExamined;
+    }
+    if (numStrips == 1) return maze.numCells() - 1;
+    return mergeStripTrees(maze, strips, wallsExamined, progress);
+}
+
+uint32_t uniformWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t, uint64_t) {
+    return counterRandom(seed, wallIndex) >> 32;
+}
+
+/*
+ * East walls draw their weights from the lower two thirds of the range and south walls from the upper two thirds, so half of
+ * the east walls are considered before any south wall.
+ */
+uint32_t corridorWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t, uint64_t) {
+    uint32_t random = counterRandom(seed, wallIndex) >> 33;
+    if ((wallIndex & 1) == kEastWall) return random;
+    return random + (1U << 30);
+}
+
+/*
+ * The field is value noise: random heights on a lattice of points noiseSpacing cells apart, blended bilinearly in between.
+ * The blended height is the top 16 bits of the weight, and the bottom 16 bits are random, to break ties between nearby walls.
+ */
+uint32_t noiseWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t row, uint64_t col) {
+    uint64_t gridRow = row / noiseSpacing;
+    uint64_t gridCol = col / noiseSpacing;
+    uint64_t rowOffset = row % noiseSpacing;
+    uint64_t colOffset = col % noiseSpacing;
+    uint64_t top = noiseAt(seed, gridRow, gridCol) * (noiseSpacing - colOffset) + noiseAt(seed, gridRow, gridCol + 1) * colOffset;
+    uint64_t bottom = noiseAt(seed, gridRow + 1, gridCol) * (noiseSpacing - colOffset)
+                    + noiseAt(seed, gridRow + 1, gridCol + 1) * colOffset;
+    uint64_t height = (top * (noiseSpacing - rowOffset) + bottom * rowOffset) / (noiseSpacing * noiseSpacing);
+    return (uint32_t) (height << 16) | (uint32_t) (counterRandom(seed, wallIndex) & 0xffff);
+}
+
+/*
+ * The weights are computed and sorted in parallel, and the sorted walls are then visited in order exactly as in
+ * generateKruskalMaze. The sort is stable and the walls are listed in index order, so equal weights keep the walls in order
+ * of index.
+ */
+uint64_t generateWeightedKruskalMaze(MazeBitplanes & maze, uint64_t seed, MazeWeightFn weightOf, int numThreads,
+                                     uint64_t & wallsExamined, MazeProgressFn progress) {
+    wallsExamined = 0;
+    if (maze.numCells() == 0) return 0;
+    numThreads = max(numThreads, 1);
+    vector<uint32_t> weights;
+    vector<uint64_t> walls;
+    reportProgress(progress, "Weighing walls", 0, 1);
+    {
+        MAZE_TIME_PHASE(INITIALIZE_WALLS_PHASE);
+        computeWallWeights(maze, seed, weightOf, numThreads, weights, walls);
+    }
+    reportProgress(progress, "Weighing walls", 1, 1);
+    reportProgress(progress, "Sorting walls", 0, 1);
+    {
+        MAZE_TIME_PHASE(SHUFFLE_PHASE);
+        radixSortWalls(weights, walls, numThreads);
+    }
+    reportProgress(progress, "Sorting walls", 1, 1);
+    vector<uint32_t>().swap(weights);
+
+    MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+    DisjointSet chambers(maze.numCells());
+    uint64_t wallsRemoved = 0;
+    uint64_t treeSize = maze.numCells() - 1;
+    while (wallsRemoved < treeSize) {
+        uint64_t wallIndex = walls[wallsExamined++];
+        uint64_t cellOne = wallIndex >> 1;
+        uint64_t cellTwo = cellOne + ((wallIndex & 1) == kEastWall ? 1 : maze.width());
+        if (chambers.merge(cellOne, cellTwo)) {
+            maze.removeWall(wallIndex);
+            wallsRemoved++;
+            reportProgress(progress, "Removing walls", wallsRemoved, treeSize);
+        }
+    }
+    MAZE_COUNT(WALLS_EXAMINED, wallsExamined);
+    MAZE_COUNT(WALLS_REMOVED, wallsRemoved);
+    return wallsRemoved;
+}
+
+/*
+ * Besides the maze, the generator holds a weight and an index for every wall, twice over while sorting, and then the
+ * disjoint-set structure.
+ */
+uint64_t weightedKruskalMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    uint64_t numWalls = countInteriorWalls(width, height);
+    uint64_t chamberBytes = width * height * (sizeof(uint64_t) + 1);
+    return planeBytes + 2 * numWalls * (sizeof(uint32_t) + sizeof(uint64_t)) + chamberBytes;
+}
+
+/*
+ * Eller's algorithm builds each row in three steps. First, neighbouring cells in different sets are joined at random (and
+ * always, on the last row), which makes the east walls of the row final. Then every set opens at least one south wall, so no
+ * set is ever cut off from the rows below; that makes the south walls final, and the row goes to the sink. Finally, the cells
+ * of the next row that were not reached through an opening are given sets of their own.
+ */
+uint64_t generateEllerMaze(uint64_t width, uint64_t height, uint64_t seed, MazeRowSink & sink, MazeProgressFn progress) {
+    ellerRow current;
+    current.setOf.resize(width);
+    current.parent.resize(width);
+    current.candidate.resize(width);
+    current.unopenedCells.resize(width);
+    current.carriedDown.resize(width);
+    current.inUse.resize(width);
+    uint64_t rowWords = (width + 63) / 64;
+    current.eastWords.resize(rowWords);
+    current.southWords.resize(rowWords);
+    for (uint64_t col = 0; col < width; col++) {
+        current.setOf[col] = col;
+    }
+
+    MazeRandom generator(seed);
+    CoinFlipper coins(generator);
+    uint64_t row = 0;
+    while (height == 0 || row < height) {
+        bool isLastRow = (row + 1 == height);
+        fill(current.eastWords.begin(), current.eastWords.end(), ~0ULL);
+        fill(current.southWords.begin(), current.southWords.end(), ~0ULL);
+        joinRowHorizontally(current, width, isLastRow, coins);
+        if (!isLastRow) carryRowDown(current, width, generator, coins);
+        bool wantsMore = sink.acceptRow(row, current.eastWords.data(), current.southWords.data());
+        row++;
+        if (height != 0) reportProgress(progress, "Streaming rows", row, height);
+        if (!wantsMore) break;
+        startNextRow(current, width);
+    }
+    return row;
+}
+
+/*
+ * Cells already in the maze are marked in the inTree bitset. A walk records, for every cell it passes through, the direction
+ * it last left that cell in (east, south, west or north, two bits per cell); walking over a cell again simply overwrites its
+ * direction, which is what erases the loop. Once the walk reaches the maze, following the recorded directions from its start
+ * retraces the loop-erased path, which is carved in and added to the maze.
+ */
+uint64_t generateWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress) {
+    return generateWilsonMaze(maze, seed, progress, ROW_MAJOR_LAYOUT);
+}
+
+uint64_t generateWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress, MazeCellLayout layout) {
+    if (layout == MORTON_LAYOUT) return growWilsonMaze(maze, seed, progress, MortonCellOrder(maze.width(), maze.height()));
+    return growWilsonMaze(maze, seed, progress, RowMajorCellOrder(maze.width(), maze.height()));
+}
+
+uint64_t wilsonMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    return planeBytes + width * height / 8 + width * height / 4;
+}
+
+/*
+ * The stack holds, for every cell on the current path except the first, the direction the path took to reach it, so backing
+ * up a step is just moving the opposite way. Every push visits a new cell, so the stack never holds more than numCells - 1
+ * entries and can be allocated once, up front.
+ */
+uint64_t generateBacktrackerMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress) {
+    uint64_t width = maze.width();
+    uint64_t height = maze.height();
+    uint64_t numCells = maze.numCells();
+    if (numCells == 0) return 0;
+    uint64_t wordsPerRow = (width + 63) / 64;
+    vector<uint64_t> visited(wordsPerRow * height, 0);
+    vector<uint8_t> stack(numCells - 1);
+    MazeRandom generator(seed);
+    uint64_t start = generator.nextBelow(numCells);
+    uint64_t row = start / width;
+    uint64_t col = start % width;
+    markVisited(visited, wordsPerRow, row, col);
+
+    uint64_t depth = 0;
+    uint64_t wallsRemoved = 0;
+    uint64_t randomBits = 0;
+    int bitsLeft = 0;
+    while (true) {
+        unsigned choices = neighbourMask(visited, wordsPerRow, width, height, row, col, false);
+        if (choices == 0) {
+            if (depth == 0) break;
+            int direction = stack[--depth];
+            row -= rowStep[direction];
+            col -= colStep[direction];
+            continue;
+        }
+        int direction = pickDirection(choices, generator, randomBits, bitsLeft);
+        carvePassage(maze, row, col, direction);
+        row += rowStep[direction];
+        col += colStep[direction];
+        markVisited(visited, wordsPerRow, row, col);
+        stack[depth++] = direction;
+        wallsRemoved++;
+        reportProgress(progress, "Carving passages", wallsRemoved, numCells - 1);
+    }
+    return wallsRemoved;
+}
+
+uint64_t backtrackerMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    return planeBytes + planeBytes / 2 + width * height;
+}
+
+/*
+ * A walk ends when every neighbour of the cell it reached is already in the maze. The hunt then picks the first cell outside
+ * the maze, scanning row by row, that has a neighbour in the maze, joins the two, and starts a new walk there. The cells
+ * before huntWord are all in the maze and stay there, so each hunt picks up where the last one left off, and the whole maze
+ * takes a single pass of hunting rather than one pass per walk.
+ */
+uint64_t generateHuntAndKillMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress) {
+    uint64_t width = maze.width();
+    uint64_t height = maze.height();
+    uint64_t numCells = maze.numCells();
+    if (numCells == 0) return 0;
+    uint64_t wordsPerRow = (width + 63) / 64;
+    vector<uint64_t> visited(wordsPerRow * height, 0);
+    MazeRandom generator(seed);
+    uint64_t start = generator.nextBelow(numCells);
+    uint64_t row = start / width;
+    uint64_t col = start % width;
+    markVisited(visited, wordsPerRow, row, col);
+
+    uint64_t cellsVisited = 1;
+    uint64_t topRow = row;
+    uint64_t huntWord = 0;
+    uint64_t randomBits = 0;
+    int bitsLeft = 0;
+    while (true) {
+        unsigned choices;
+        while ((choices = neighbourMask(visited, wordsPerRow, width, height, row, col, false)) != 0) {
+            int direction = pickDirection(choices, generator, randomBits, bitsLeft);
+            carvePassage(maze, row, col, direction);
+            row += rowStep[direction];
+            col += colStep[direction];
+            markVisited(visited, wordsPerRow, row, col);
+            if (row < topRow) topRow = row;
+            cellsVisited++;
+            reportProgress(progress, "Carving passages", cellsVisited, numCells);
+        }
+        if (cellsVisited == numCells) break;
+
+        findHuntedCell(visited, wordsPerRow, width, height, topRow, huntWord, row, col);
+        int direction = pickDirection(neighbourMask(visited, wordsPerRow, width, height, row, col, true), generator,
+                                      randomBits, bitsLeft);
+        carvePassage(maze, row, col, direction);
+        markVisited(visited, wordsPerRow, row, col);
+        if (row < topRow) topRow = row;
+        cellsVisited++;
+        reportProgress(progress, "Carving passages", cellsVisited, numCells);
+    }
+    return numCells - 1;
+}
+
+uint64_t huntAndKillMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    return planeBytes + planeBytes / 2;
+}
+
+uint64_t ellerMemoryEstimate(uint64_t width) {
+    return width * (4 * sizeof(uint32_t) + 2 * sizeof(char)) + 2 * ((width + 63) / 64) * sizeof(uint64_t);
+}
+
+BitplanesRowSink::BitplanesRowSink(MazeBitplanes & maze) : destination(maze) {
+}
+
+bool BitplanesRowSink::acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords) {
+    if (row >= destination.height()) return false;
+    copy(eastWords, eastWords + destination.wordsPerRow(), destination.eastRow(row));
+    copy(southWords, southWords + destination.wordsPerRow(), destination.southRow(row));
+    return row + 1 < destination.height();
+}
+
+/*
+ * The threads take blocks of concurrentBlockSize walls from the front of the shuffled list, so the walls are visited in
+ * close to the shuffled order, and stop taking blocks once the tree is complete. Each thread keeps its own list of the walls
+ * it removed, and the maze is only touched once every thread is done, since removing walls from the bitplanes at the same
+ * time from several threads could lose some of the removals that share a word.
+ */
+uint64_t generateConcurrentKruskalMaze(MazeBitplanes & maze, uint64_t seed, int numThreads, uint64_t & wallsExamined,
+                                       MazeProgressFn progress) {
+    wallsExamined = 0;
+    if (maze.numCells() == 0) return 0;
+    numThreads = max(numThreads, 1);
+    vector<uint64_t> walls;
+    listInteriorWalls(maze, walls, progress);
+    MazeRandom generator(seed);
+    reportProgress(progress, "Shuffling walls", 0, 1);
+    {
+        MAZE_TIME_PHASE(SHUFFLE_PHASE);
+        if (!walls.empty()) shuffleInPlace(&walls[0], walls.size(), generator);
+    }
+    reportProgress(progress, "Shuffling walls", 1, 1);
+
+    reportProgress(progress, "Removing walls", 0, 1);
+    ConcurrentDisjointSet chambers(maze.numCells());
+    uint64_t width = maze.width();
+    uint64_t treeSize = maze.numCells() - 1;
+    atomic<uint64_t> nextBlock(0);
+    atomic<uint64_t> wallsRemoved(0);
+    vector<vector<uint64_t> > removed(numThreads);
+    vector<uint64_t> examined(numThreads, 0);
+    auto work = [&](int slice) {
+        MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+        while (wallsRemoved.load(memory_order_relaxed) < treeSize) {
+            uint64_t first = nextBlock.fetch_add(concurrentBlockSize, memory_order_relaxed);
+            if (first >= walls.size()) break;
+            uint64_t end = min<uint64_t>(first + concurrentBlockSize, walls.size());
+            uint64_t found = 0;
+            for (uint64_t i = first; i < end; i++) {
+                uint64_t cellOne = walls[i] >> 1;
+                uint64_t cellTwo = cellOne + ((walls[i] & 1) == kEastWall ? 1 : width);
+                if (chambers.merge(cellOne, cellTwo)) {
+                    removed[slice].push_back(walls[i]);
+                    found++;
+                }
+            }
+            examined[slice] += end - first;
+            wallsRemoved.fetch_add(found, memory_order_relaxed);
+        }
+    };
+    vector<thread> workers;
+    for (int i = 1; i < numThreads; i++) {
+        workers.push_back(thread(work, i));
+    }
+    work(0);
+    for (uint64_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    {
+        MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+        for (int i = 0; i < numThreads; i++) {
+            wallsExamined += examined[i];
+            for (uint64_t wallIndex : removed[i]) {
+                maze.removeWall(wallIndex);
+            }
+        }
+    }
+    MAZE_COUNT(WALLS_EXAMINED, wallsExamined);
+    MAZE_COUNT(WALLS_REMOVED, treeSize);
+    reportProgress(progress, "Removing walls", 1, 1);
+    return treeSize;
+}
+
+uint64_t concurrentKruskalMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    return planeBytes + countInteriorWalls(width, height) * sizeof(uint64_t) + 2 * width * height * sizeof(uint64_t);
+}
+
+uint64_t kruskalMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    uint64_t chamberBytes = width * height * (sizeof(uint64_t) + 1);
+    return planeBytes + countInteriorWalls(width, height) * sizeof(uint64_t) + chamberBytes;
+}
+
+uint64_t parallelKruskalMemoryEstimate(uint64_t width, uint64_t height) {
+    uint64_t planeBytes = 2 * ((width + 63) / 64) * height * sizeof(uint64_t);
+    uint64_t chamberBytes = width * height * (sizeof(uint64_t) + 1);
+    return planeBytes + 2 * countInteriorWalls(width, height) * (sizeof(uint32_t) + sizeof(uint64_t)) + chamberBytes;
+}
+
+/*
+ * This method returns the first cell not yet in the maze, scanning the inTree bitset a word at a time. searchWord remembers
+ * where the last search left off; cells before it are never removed from the maze, so they never need to be scanned again.
+ */
+static uint64_t findCellOutsideTree(const vector<uint64_t> & inTree, const RowMajorCellOrder &, uint64_t numCells,
+                                    uint64_t & searchWord) {
+    while (true) {
+        uint64_t missing = ~inTree[searchWord];
+        if (searchWord == inTree.size() - 1 && numCells % 64 != 0) missing &= (1ULL << (numCells % 64)) - 1;
+        if (missing != 0) return searchWord * 64 + __builtin_ctzll(missing);
+        searchWord++;
+    }
+}
+
+/*
+ * This method does the same for a tree stored in Morton order, returning the row-by-row index of the first cell outside it.
+ * searchCell is the first cell not yet known to be in the tree, and it only ever moves forward.
+ */
+static uint64_t findCellOutsideTree(const vector<uint64_t> & inTree, const MortonCellOrder & order, uint64_t,
+                                    uint64_t & searchCell) {
+    while (true) {
+        uint64_t index = order.indexOfCell(searchCell);
+        if (!((inTree[index / 64] >> (index % 64)) & 1)) return searchCell;
+        searchCell++;
+    }
+}
+
+/*
+ * This method returns a mask with bit d set for every direction d in which the cell has a neighbour inside the maze that has
+ * been visited (if wantVisited is true) or not (if it is false). visited has wordsPerRow words for every row of the maze.
+ */
+static unsigned neighbourMask(const vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t width, uint64_t height,
+                              uint64_t row, uint64_t col, bool wantVisited) {
+    unsigned mask = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        if ((direction == 0 && col + 1 == width) || (direction == 1 && row + 1 == height)
+                || (direction == 2 && col == 0) || (direction == 3 && row == 0)) continue;
+        uint64_t nextRow = row + rowStep[direction];
+        uint64_t nextCol = col + colStep[direction];
+        bool isVisited = (visited[nextRow * wordsPerRow + nextCol / 64] >> (nextCol % 64)) & 1;
+        if (isVisited == wantVisited) mask |= 1 << direction;
+    }
+    return mask;
+}
+
+/*
+ * This method picks one of the directions set in choices, each equally likely, drawing two random bits at a time and
+ * rejecting directions that are not set. The bits come out of a buffer refilled 64 at a time, so most choices cost a shift
+ * rather than a call to the generator, and a lone choice costs nothing at all.
+ */
+static int pickDirection(unsigned choices, MazeRandom & generator, uint64_t & randomBits, int & bitsLeft) {
+    if ((choices & (choices - 1)) == 0) return __builtin_ctz(choices);
+    while (true) {
+        if (bitsLeft == 0) {
+            randomBits = generator.next();
+            bitsLeft = 32;
+        }
+        int direction = randomBits & 3;
+        randomBits >>= 2;
+        bitsLeft--;
+        if ((choices >> direction) & 1) return direction;
+    }
+}
+
+/*
+ * This method removes the wall on the given side of a cell.
+ */
+static void carvePassage(MazeBitplanes & maze, uint64_t row, uint64_t col, int direction) {
+    if (direction == 0) maze.removeEastWall(row, col);
+    else if (direction == 1) maze.removeSouthWall(row, col);
+    else if (direction == 2) maze.removeEastWall(row, col - 1);
+    else maze.removeSouthWall(row - 1, col);
+}
+
+static void markVisited(vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t row, uint64_t col) {
+    visited[row * wordsPerRow + col / 64] |= 1ULL << (col % 64);
+}
+
+/*
+ * This method finds the cell the next walk of hunt-and-kill starts from: the first unvisited cell, row by row, with a visited
+ * neighbour. Any unvisited cell other than the top left one has a visited neighbour to its north or west, because those cells
+ * come before it, so the first unvisited cell is almost always the answer, and huntWord, the first word with an unvisited
+ * cell, finds it without rescanning the words before. The exception is while the top left cell is still unvisited. Then no
+ * row above topRow - 1 has a visited neighbour, and rows topRow - 1 and topRow always hold one, so only those rows are
+ * searched, a word at a time.
+ */
+static void findHuntedCell(const vector<uint64_t> & visited, uint64_t wordsPerRow, uint64_t width, uint64_t height,
+                           uint64_t topRow, uint64_t & huntWord, uint64_t & row, uint64_t & col) {
+    uint64_t missing;
+    while ((missing = ~visited[huntWord] & rowWordMask(huntWord % wordsPerRow, wordsPerRow, width)) == 0) {
+        huntWord++;
+    }
+    row = huntWord / wordsPerRow;
+    col = 64 * (huntWord % wordsPerRow) + __builtin_ctzll(missing);
+    if (row != 0 || col != 0 || neighbourMask(visited, wordsPerRow, width, height, 0, 0, true) != 0) return;
+    for (row = (topRow == 0 ? 0 : topRow - 1); ; row++) {
+        const uint64_t *words = &visited[row * wordsPerRow];
+        for (uint64_t word = 0; word < wordsPerRow; word++) {
+            uint64_t beside = (words[word] << 1) | (words[word] >> 1);
+            if (word > 0) beside |= words[word - 1] >> 63;
+            if (word + 1 < wordsPerRow) beside |= words[word + 1] << 63;
+            if (row > 0) beside |= words[word - wordsPerRow];
+            if (row + 1 < height) beside |= words[word + wordsPerRow];
+            uint64_t candidates = ~words[word] & beside & rowWordMask(word, wordsPerRow, width);
+            if (candidates != 0) {
+                col = 64 * word + __builtin_ctzll(candidates);
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * This method returns the mask of the bits of a row's word that stand for cells of the maze, leaving out the padding at the
+ * end of the row.
+ */
+static uint64_t rowWordMask(uint64_t wordInRow, uint64_t wordsPerRow, uint64_t width) {
+    if (wordInRow + 1 < wordsPerRow || width % 64 == 0) return ~0ULL;
+    return (1ULL << (width % 64)) - 1;
+}
+
+static bool operator<(const weightedWall & one, const weightedWall & two) {
+    if (one.weight != two.weight) return one.weight < two.weight;
+    return one.wallIndex < two.wallIndex;
+}
+
+static bool operator<(const stripLink & one, const stripLink & two) {
+    return one.wall < two.wall;
+}
+
+/*
+ * This method runs Kruskal's algorithm on a single strip: it gives every wall inside the strip a weight, radix sorts them (see
+ * radixSortWalls), and removes the walls whose removal would join two chambers of the strip, using a disjoint-set structure
+ * over just the strip's cells. The walls it leaves standing close a cycle of lighter walls within the strip, so Kruskal's
+ * algorithm over the whole maze would leave them standing as well. The walls between this strip and the next get their weights
+ * here too, but are left for the merge. As in generateKruskalMaze, the pass stops as soon as the strip's tree is complete. When
+ * the strip is not the whole maze, its tree is then shrunk for the merge.
+ */
+static void buildStripTree(MazeBitplanes & maze, mazeStrip & strip, uint64_t seed) {
+    uint64_t width = maze.width();
+    uint64_t firstCell = strip.firstRow * width;
+    bool isLastStrip = strip.endRow == maze.height();
+    uint64_t numWalls = countInteriorWalls(width, strip.endRow - strip.firstRow);
+    vector<uint32_t> weights;
+    vector<uint64_t> walls;
+    {
+        MAZE_TIME_PHASE(INITIALIZE_WALLS_PHASE);
+        weights.reserve(numWalls);
+        walls.reserve(numWalls);
+        for (uint64_t row = strip.firstRow; row < strip.endRow; row++) {
+            for (uint64_t col = 0; col < width; col++) {
+                uint64_t cellIndex = row * width + col;
+                if (col + 1 < width) {
+                    walls.push_back(makeWallIndex(cellIndex, kEastWall));
+                    weights.push_back(uniformWallWeight(seed, walls.back(), row, col));
+                }
+                if (row + 1 < strip.endRow) {
+                    walls.push_back(makeWallIndex(cellIndex, kSouthWall));
+                    weights.push_back(uniformWallWeight(seed, walls.back(), row, col));
+                } else if (!isLastStrip) {
+                    uint64_t boundaryWallIndex = makeWallIndex(cellIndex, kSouthWall);
+                    weightedWall boundaryWall = { uniformWallWeight(seed, boundaryWallIndex, row, col), boundaryWallIndex };
+                    strip.boundaryWalls.push_back(boundaryWall);
+                }
+            }
+        }
+    }
+    {
+        MAZE_TIME_PHASE(SHUFFLE_PHASE);
+        radixSortWalls(weights, walls, 1);
+    }
+
+    MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+    DisjointSet chambers((strip.endRow - strip.firstRow) * width);
+    uint64_t treeSize = chambers.size() - 1;
+    uint64_t wallsRemoved = 0;
+    strip.wallsExamined = 0;
+    while (wallsRemoved < treeSize) {
+        uint64_t next = strip.wallsExamined++;
+        uint64_t cellOne = (walls[next] >> 1) - firstCell;
+        uint64_t cellTwo = cellOne + ((walls[next] & 1) == kEastWall ? 1 : width);
+        if (chambers.merge(cellOne, cellTwo)) {
+            maze.removeWall(walls[next]);
+            wallsRemoved++;
+        }
+    }
+    MAZE_COUNT(WALLS_EXAMINED, strip.wallsExamined);
+    MAZE_COUNT(WALLS_REMOVED, wallsRemoved);
+    if (strip.firstRow > 0 || !isLastStrip) {
+        vector<uint32_t>().swap(weights);
+        vector<uint64_t>().swap(walls);
+        compressStripTree(maze, strip, seed);
+    }
+}
+
+/*
+ * This method shrinks a strip's tree to what the merge needs. The key cells are the cells of the strip's rows next to other
+ * strips, which the walls between strips can join to the rest of the maze, and the cells where the tree branches. First, every
+ * branch of the tree that holds no cell next to another strip is pruned away, leaf by leaf: no wall between strips touches it,
+ * so no cycle in the whole maze can pass through it, and every one of its walls stays removed. What is left is made of paths
+ * between key cells whose inner cells each have just two neighbours, and any cycle through one of those cells follows the whole
+ * path. So the merge only ever needs the heaviest wall of each path: the lighter ones can never be the heaviest wall of a cycle,
+ * and stay removed no matter what. Each path is walked from both of its ends, but only recorded from the lower one. Key cells
+ * are numbered in cell order, so the first row's cells are keys 0 up to the width, and the last row's are the last width keys.
+ */
+static void compressStripTree(const MazeBitplanes & maze, mazeStrip & strip, uint64_t seed) {
+    uint64_t width = maze.width();
+    uint64_t numCells = (strip.endRow - strip.firstRow) * width;
+    uint64_t firstInnerCell = strip.firstRow > 0 ? width : 0;
+    uint64_t endInnerCell = strip.endRow < maze.height() ? numCells - width : numCells;
+    vector<uint8_t> degree(numCells);
+    vector<uint64_t> leaves;
+    uint64_t neighbours[4];
+    for (uint64_t cell = 0; cell < numCells; cell++) {
+        degree[cell] = findStripNeighbours(maze, strip, cell, neighbours);
+        bool isInner = cell >= firstInnerCell && cell < endInnerCell;
+        if (isInner && degree[cell] == 1) leaves.push_back(cell);
+    }
+    while (!leaves.empty()) {
+        uint64_t leaf = leaves.back();
+        leaves.pop_back();
+        degree[leaf] = 0;
+        int numNeighbours = findStripNeighbours(maze, strip, leaf, neighbours);
+        for (int i = 0; i < numNeighbours; i++) {
+            uint64_t next = neighbours[i];
+            if (degree[next] == 0) continue;
+            bool isInner = next >= firstInnerCell && next < endInnerCell;
+            if (--degree[next] == 1 && isInner) leaves.push_back(next);
+        }
+    }
+
+    vector<uint64_t> keyCells;
+    for (uint64_t cell = 0; cell < numCells; cell++) {
+        if (cell < firstInnerCell || cell >= endInnerCell || degree[cell] >= 3) keyCells.push_back(cell);
+    }
+    strip.numKeys = keyCells.size();
+    for (uint64_t key = 0; key < keyCells.size(); key++) {
+        int numNeighbours = findStripNeighbours(maze, strip, keyCells[key], neighbours);
+        for (int i = 0; i < numNeighbours; i++) {
+            if (degree[neighbours[i]] == 0) continue;
+            uint64_t previous = keyCells[key];
+            uint64_t current = neighbours[i];
+            weightedWall heaviest = stripWallBetween(maze, strip, seed, previous, current);
+            while (current >= firstInnerCell && current < endInnerCell && degree[current] == 2) {
+                uint64_t pathNeighbours[4];
+                int numPathNeighbours = findStripNeighbours(maze, strip, current, pathNeighbours);
+                uint64_t next = current;
+                for (int j = 0; j < numPathNeighbours; j++) {
+                    if (pathNeighbours[j] != previous && degree[pathNeighbours[j]] != 0) next = pathNeighbours[j];
+                }
+                weightedWall wall = stripWallBetween(maze, strip, seed, current, next);
+                if (heaviest < wall) heaviest = wall;
+                previous = current;
+                current = next;
+            }
+            if (keyCells[key] < current) {
+                uint64_t otherKey = lower_bound(keyCells.begin(), keyCells.end(), current) - keyCells.begin();
+                stripLink link = { heaviest, key, otherKey, false };
+                strip.links.push_back(link);
+            }
+        }
+    }
+}
+
+/*
+ * This method fills neighbours with the cells of the strip that the given cell has an open passage to, and returns how many
+ * there are. Cells are numbered from the start of the strip, and passages into other strips are not counted.
+ */
+static int findStripNeighbours(const MazeBitplanes & maze, const mazeStrip & strip, uint64_t cell, uint64_t neighbours[]) {
+    uint64_t width = maze.width();
+    uint64_t row = strip.firstRow + cell / width;
+    uint64_t col = cell % width;
+    int numNeighbours = 0;
+    if (row > strip.firstRow && !maze.hasSouthWall(row - 1, col)) neighbours[numNeighbours++] = cell - width;
+    if (col > 0 && !maze.hasEastWall(row, col - 1)) neighbours[numNeighbours++] = cell - 1;
+    if (col + 1 < width && !maze.hasEastWall(row, col)) neighbours[numNeighbours++] = cell + 1;
+    if (row + 1 < strip.endRow && !maze.hasSouthWall(row, col)) neighbours[numNeighbours++] = cell + width;
+    return numNeighbours;
+}
+
+/*
+ * This method returns the wall between two neighbouring cells of a strip, numbered from the start of the strip, along with its
+ * weight.
+ */
+static weightedWall stripWallBetween(const MazeBitplanes & maze, const mazeStrip & strip, uint64_t seed, uint64_t one,
+                                     uint64_t two) {
+    uint64_t width = maze.width();
+    uint64_t cell = min(one, two);
+    uint64_t row = strip.firstRow + cell / width;
+    uint64_t col = cell % width;
+    uint64_t wallIndex = makeWallIndex(row * width + col, max(one, two) - cell == width ? kSouthWall : kEastWall);
+    weightedWall wall = { uniformWallWeight(seed, wallIndex, row, col), wallIndex };
+    return wall;
+}
+
+/*
+ * This method finishes the parallel generator with Kruskal's algorithm over the key cells of every strip. Its edges are the
+ * paths each strip was shrunk to and the walls between strips, visited in weight order. A wall between strips that joins two
+ * chambers is removed. A path that would close a cycle instead has its heaviest wall put back, which splits the strip's tree
+ * there; every other wall the strips removed stays removed. Each strip is shrunk to a few keys per column at most, so the merge
+ * takes time in proportion to the width of the maze times the number of strips, not to the number of cells. Every edge it
+ * looks at is added to wallsExamined. The strips have already counted their own removals for the instrumentation, so the merge
+ * adds only the difference it makes.
+ */
+static uint64_t mergeStripTrees(MazeBitplanes & maze, const vector<mazeStrip> & strips, uint64_t & wallsExamined,
+                                MazeProgressFn progress) {
+    MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+    vector<stripLink> links;
+    uint64_t wallsRemoved = 0;
+    uint64_t firstKey = 0;
+    for (uint64_t i = 0; i < strips.size(); i++) {
+        for (const stripLink & link : strips[i].links) {
+            stripLink shifted = { link.wall, firstKey + link.one, firstKey + link.two, false };
+            links.push_back(shifted);
+        }
+        uint64_t firstBottomKey = firstKey + strips[i].numKeys - maze.width();
+        for (uint64_t col = 0; col < strips[i].boundaryWalls.size(); col++) {
+            stripLink boundary = { strips[i].boundaryWalls[col], firstBottomKey + col, firstKey + strips[i].numKeys + col, true };
+            links.push_back(boundary);
+        }
+        wallsRemoved += (strips[i].endRow - strips[i].firstRow) * maze.width() - 1;
+        firstKey += strips[i].numKeys;
+    }
+    sort(links.begin(), links.end());
+
+#ifdef MAZE_INSTRUMENTATION
+    uint64_t stripWallsRemoved = wallsRemoved;
+#endif
+    DisjointSet keys(firstKey);
+    for (uint64_t i = 0; i < links.size(); i++) {
+        if (keys.merge(links[i].one, links[i].two)) {
+            if (links[i].joinsStrips) {
+                maze.removeWall(links[i].wall.wallIndex);
+                wallsRemoved++;
+            }
+        } else if (!links[i].joinsStrips) {
+            restoreWall(maze, links[i].wall.wallIndex);
+            wallsRemoved--;
+        }
+        reportProgress(progress, "Merging strips", i + 1, links.size());
+    }
+    wallsExamined += links.size();
+    MAZE_COUNT(WALLS_EXAMINED, links.size());
+    MAZE_COUNT(WALLS_REMOVED, wallsRemoved - stripWallsRemoved);
+    return wallsRemoved;
+}
+
+/*
+ * This method puts back a wall that was removed.
+ */
+static void restoreWall(MazeBitplanes & maze, uint64_t wallIndex) {
+    uint64_t cellIndex = wallIndex >> 1;
+    uint64_t row = cellIndex / maze.width();
+    uint64_t col = cellIndex % maze.width();
+    uint64_t *plane = (wallIndex & 1) == kEastWall ? maze.eastRow(row) : maze.southRow(row);
+    plane[col / 64] |= 1ULL << (col % 64);
+}
+
+/*
+ * This method returns the number of walls that separate two cells of the maze: one to the east of every cell outside the last
+ * column, and one to the south of every cell outside the last row.
+ */
+static uint64_t countInteriorWalls(uint64_t width, uint64_t height) {
+    if (width == 0 || height == 0) return 0;
+    return (width - 1) * height + width * (height - 1);
+}
+
+/*
+ * This method fills a vector with the index of every interior wall of the maze, going row by row.
+ */
+static void listInteriorWalls(const MazeBitplanes & maze, vector<uint64_t> & walls, MazeProgressFn progress) {
+    MAZE_TIME_PHASE(INITIALIZE_WALLS_PHASE);
+    walls.clear();
+    walls.reserve(countInteriorWalls(maze.width(), maze.height()));
+    for (uint64_t row = 0; row < maze.height(); row++) {
+        for (uint64_t col = 0; col < maze.width(); col++) {
+            uint64_t cellIndex = row * maze.width() + col;
+            if (col + 1 < maze.width()) walls.push_back(makeWallIndex(cellIndex, kEastWall));
+            if (row + 1 < maze.height()) walls.push_back(makeWallIndex(cellIndex, kSouthWall));
+        }
+        reportProgress(progress, "Listing walls", row + 1, maze.height());
+    }
+}
+
+/*
+ * This method passes progress on to the caller's progress function, but only when another hundredth of the phase has been
+ * completed (and at the very end), so that reporting costs next to nothing inside the generators' loops.
+ */
+static void reportProgress(MazeProgressFn progress, const char *phase, uint64_t done, uint64_t total) {
+    if (progress == NULL || total == 0) return;
+    uint64_t stepSize = total / progressSteps + 1;
+    if (done % stepSize == 0 || done == total) {
+        progress(phase, (double) done / total);
+    }
+}
+
+/*
+ * This method knocks down the east wall between neighbouring cells that are in different sets, each with even odds, or always
+ * on the last row of the maze so that every set ends up joined. Each knocked-down wall merges the two sets. Once every wall has
+ * been decided, each cell is relabeled with the set it ended up in.
+ */
+static void joinRowHorizontally(ellerRow & current, uint64_t width, bool isLastRow, CoinFlipper & coins) {
+    for (uint64_t id = 0; id < width; id++) {
+        current.parent[id] = id;
+    }
+    for (uint64_t col = 0; col + 1 < width; col++) {
+        uint32_t westSet = findRowSet(current, current.setOf[col]);
+        uint32_t eastSet = findRowSet(current, current.setOf[col + 1]);
+        if (westSet != eastSet && (isLastRow || coins.flip())) {
+            current.eastWords[col / 64] &= ~(1ULL << (col % 64));
+            current.parent[eastSet] = westSet;
+        }
+    }
+    for (uint64_t col = 0; col < width; col++) {
+        current.setOf[col] = findRowSet(current, current.setOf[col]);
+    }
+}
+
+/*
+ * This method opens the south wall of each cell with even odds. A set that opened none of its cells gets one opening anyway,
+ * in a cell picked uniformly from its cells by reservoir sampling while the row is scanned, so no set is sealed off.
+ */
+static void carryRowDown(ellerRow & current, uint64_t width, MazeRandom & generator, CoinFlipper & coins) {
+    for (uint64_t id = 0; id < width; id++) {
+        current.carriedDown[id] = false;
+        current.unopenedCells[id] = 0;
+    }
+    for (uint64_t col = 0; col < width; col++) {
+        uint32_t id = current.setOf[col];
+        if (coins.flip()) {
+            current.southWords[col / 64] &= ~(1ULL << (col % 64));
+            current.carriedDown[id] = true;
+        } else if (generator.nextBelow(++current.unopenedCells[id]) == 0) {
+            current.candidate[id] = col;
+        }
+    }
+    for (uint64_t col = 0; col < width; col++) {
+        uint32_t id = current.setOf[col];
+        if (!current.carriedDown[id] && current.candidate[id] == col) {
+            current.southWords[col / 64] &= ~(1ULL << (col % 64));
+            current.carriedDown[id] = true;
+        }
+    }
+}
+
+/*
+ * This method prepares the sets of the next row. A cell below an opening stays in the set of the cell above it; every other
+ * cell gets an id that no set is using. There are always enough free ids, since each set in use covers at least one cell.
+ */
+static void startNextRow(ellerRow & current, uint64_t width) {
+    for (uint64_t id = 0; id < width; id++) {
+        current.inUse[id] = false;
+    }
+    for (uint64_t col = 0; col < width; col++) {
+        if (!((current.southWords[col / 64] >> (col % 64)) & 1)) current.inUse[current.setOf[col]] = true;
+    }
+    uint64_t nextFreeId = 0;
+    for (uint64_t col = 0; col < width; col++) {
+        if ((current.southWords[col / 64] >> (col % 64)) & 1) {
+            while (current.inUse[nextFreeId]) nextFreeId++;
+            current.setOf[col] = nextFreeId;
+            current.inUse[nextFreeId] = true;
+        }
+    }
+}
+
+/*
+ * This method returns the set a set id has been merged into on the current row, halving the path to it along the way.
+ */
+static uint32_t findRowSet(ellerRow & current, uint32_t setId) {
+    while (current.parent[setId] != setId) {
+        current.parent[setId] = current.parent[current.parent[setId]];
+        setId = current.parent[setId];
+    }
+    return setId;
+}
+
+/*
+ * This method lists every interior wall of the maze in index order, along with its weight, splitting the rows between
+ * numThreads threads. Every row but the last has width - 1 east walls and width south walls, so the walls of row r start at
+ * r * (2 * width - 1) and each thread can fill in its own rows without waiting for the others.
+ */
+static void computeWallWeights(const MazeBitplanes & maze, uint64_t seed, MazeWeightFn weightOf, int numThreads,
+                               vector<uint32_t> & weights, vector<uint64_t> & walls) {
+    uint64_t width = maze.width();
+    uint64_t height = maze.height();
+    uint64_t numWalls = countInteriorWalls(width, height);
+    weights.resize(numWalls);
+    walls.resize(numWalls);
+    runInSlices(numThreads, height, [&](int, uint64_t firstRow, uint64_t endRow) {
+        uint64_t next = firstRow * (2 * width - 1);
+        for (uint64_t row = firstRow; row < endRow; row++) {
+            for (uint64_t col = 0; col < width; col++) {
+                uint64_t cellIndex = row * width + col;
+                if (col + 1 < width) {
+                    walls[next] = makeWallIndex(cellIndex, kEastWall);
+                    weights[next] = weightOf(seed, walls[next], row, col);
+                    next++;
+                }
+                if (row + 1 < height) {
+                    walls[next] = makeWallIndex(cellIndex, kSouthWall);
+                    weights[next] = weightOf(seed, walls[next], row, col);
+                    next++;
+                }
+            }
+        }
+    });
+}
+
+/*
+ * This method sorts the walls by weight with a least-significant-digit radix sort: four stable passes, each distributing the
+ * walls into 256 buckets by one byte of their weights, from the lowest byte to the highest. Each pass is split into one slice
+ * of the walls per thread. Every thread first counts the digits in its own slice; the counts then give each thread the exact
+ * position in every bucket where its walls go, in digit-major, slice-minor order, so the threads scatter their slices into the
+ * second buffer at the same time without touching each other's positions, and the order within a bucket stays stable. A pass
+ * where every wall has the same digit would change nothing, so it is skipped. Each pass reads and writes every wall once, so
+ * the whole sort takes linear time, and the two buffers swap roles after every pass.
+ */
+static void radixSortWalls(vector<uint32_t> & weights, vector<uint64_t> & walls, int numThreads) {
+    uint64_t count = weights.size();
+    int numSlices = (int) min<uint64_t>(numThreads, max<uint64_t>(count / radixBuckets, 1));
+    vector<uint32_t> weightBuffer(count);
+    vector<uint64_t> wallBuffer(count);
+    vector<uint64_t> offsets(numSlices * radixBuckets);
+    for (int shift = 0; shift < 32; shift += radixBits) {
+        fill(offsets.begin(), offsets.end(), 0);
+        runInSlices(numSlices, count, [&](int slice, uint64_t begin, uint64_t end) {
+            uint64_t *sliceCounts = &offsets[slice * radixBuckets];
+            for (uint64_t i = begin; i < end; i++) {
+                sliceCounts[(weights[i] >> shift) & (radixBuckets - 1)]++;
+            }
+        });
+        bool allInOneBucket = false;
+        uint64_t position = 0;
+        for (int digit = 0; digit < radixBuckets; digit++) {
+            uint64_t bucketSize = 0;
+            for (int slice = 0; slice < numSlices; slice++) {
+                uint64_t sliceCount = offsets[slice * radixBuckets + digit];
+                offsets[slice * radixBuckets + digit] = position;
+                position += sliceCount;
+                bucketSize += sliceCount;
+            }
+            if (bucketSize == count) allInOneBucket = true;
+        }
+        if (allInOneBucket) continue;
+        runInSlices(numSlices, count, [&](int slice, uint64_t begin, uint64_t end) {
+            uint64_t *sliceOffsets = &offsets[slice * radixBuckets];
+            for (uint64_t i = begin; i < end; i++) {
+                uint64_t destination = sliceOffsets[(weights[i] >> shift) & (radixBuckets - 1)]++;
+                weightBuffer[destination] = weights[i];
+                wallBuffer[destination] = walls[i];
+            }
+        });
+        weights.swap(weightBuffer);
+        walls.swap(wallBuffer);
+    }
+}
+
+/*
+ * This method splits the numbers from 0 to count - 1 into numSlices consecutive ranges and calls work on each one, passing
+ * the slice number and the range, with every slice but the first on a thread of its own.
+ */
+static void runInSlices(int numSlices, uint64_t count, const function<void(int, uint64_t, uint64_t)> & work) {
+    vector<thread> workers;
+    for (int slice = 1; slice < numSlices; slice++) {
+        workers.push_back(thread(work, slice, count * slice / numSlices, count * (slice + 1) / numSlices));
+    }
+    work(0, 0, count / numSlices);
+    for (uint64_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+/*
+ * This method returns the 16-bit height of the noise field at a lattice point.
+ */
+static uint32_t noiseAt(uint64_t seed, uint64_t gridRow, uint64_t gridCol) {
+    return counterRandom(seed ^ noiseSalt, (gridRow << 32) | gridCol) >> 48;
+}
+
+/*
+ * This method visits the shuffled walls for generateKruskalMaze, with the disjoint-set structure numbering the cells by the
+ * given order.
+ */
+template <typename CellOrder>
+static uint64_t removeShuffledWalls(MazeBitplanes & maze, const vector<uint64_t> & walls, DisjointSet & chambers,
+                                    const CellOrder & order, uint64_t & wallsExamined, MazeProgressFn progress) {
+    MAZE_TIME_PHASE(REMOVE_WALLS_PHASE);
+    chambers.reset(order.size());
+    uint64_t wallsRemoved = 0;
+    uint64_t treeSize = maze.numCells() - 1;
+    while (wallsRemoved < treeSize) {
+        uint64_t wallIndex = walls[wallsExamined++];
+        uint64_t cellOne = wallIndex >> 1;
+        uint64_t cellTwo = cellOne + ((wallIndex & 1) == kEastWall ? 1 : maze.width());
+        if (chambers.merge(order.indexOfCell(cellOne), order.indexOfCell(cellTwo))) {
+            maze.removeWall(wallIndex);
+            wallsRemoved++;
+            reportProgress(progress, "Removing walls", wallsRemoved, treeSize);
+        }
+    }
+    MAZE_COUNT(WALLS_EXAMINED, wallsExamined);
+    MAZE_COUNT(WALLS_REMOVED, wallsRemoved);
+    return wallsRemoved;
+}
+
+/*
+ * This method is Wilson's algorithm itself, with the working bitsets numbered by the given order. Walks always start from the
+ * first cell outside the tree in row-by-row order, so the walks, and the maze, are the same in every order; only the positions
+ * of the bits change.
+ */
+template <typename CellOrder>
+static uint64_t growWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress, const CellOrder & order) {
+    uint64_t width = maze.width();
+    uint64_t height = maze.height();
+    uint64_t numCells = maze.numCells();
+    if (numCells == 0) return 0;
+    vector<uint64_t> inTree((order.size() + 63) / 64, 0);
+    vector<uint8_t> directions((order.size() + 3) / 4, 0);
+    MazeRandom generator(seed);
+    uint64_t root = order.indexOfCell(generator.nextBelow(numCells));
+    inTree[root / 64] |= 1ULL << (root % 64);
+
+    uint64_t cellsInTree = 1;
+    uint64_t search = 0;
+    uint64_t randomBits = 0;
+    int bitsLeft = 0;
+    while (cellsInTree < numCells) {
+        uint64_t startCell = findCellOutsideTree(inTree, order, numCells, search);
+        uint64_t start = order.indexOfCell(startCell);
+        uint64_t row = startCell / width;
+        uint64_t col = startCell % width;
+        uint64_t current = start;
+        while (!((inTree[current / 64] >> (current % 64)) & 1)) {
+            int direction;
+            while (true) {
+                if (bitsLeft == 0) {
+                    randomBits = generator.next();
+                    bitsLeft = 32;
+                }
+                direction = randomBits & 3;
+                randomBits >>= 2;
+                bitsLeft--;
+                if ((direction == 0 && col + 1 < width) || (direction == 1 && row + 1 < height)
+                        || (direction == 2 && col > 0) || (direction == 3 && row > 0)) break;
+            }
+            int shift = 2 * (current % 4);
+            directions[current / 4] = (directions[current / 4] & ~(3 << shift)) | (direction << shift);
+            row += rowStep[direction];
+            col += colStep[direction];
+            current = order.indexOf(row, col);
+        }
+
+        current = start;
+        row = startCell / width;
+        col = startCell % width;
+        while (!((inTree[current / 64] >> (current % 64)) & 1)) {
+            inTree[current / 64] |= 1ULL << (current % 64);
+            int direction = (directions[current / 4] >> (2 * (current % 4))) & 3;
+            if (direction == 0) maze.removeEastWall(row, col);
+            else if (direction == 1) maze.removeSouthWall(row, col);
+            else if (direction == 2) maze.removeEastWall(row, col - 1);
+            else maze.removeSouthWall(row - 1, col);
+            row += rowStep[direction];
+            col += colStep[direction];
+            current = order.indexOf(row, col);
+            cellsInTree++;
+        }
+        reportProgress(progress, "Growing the maze", cellsInTree, numCells);
+    }
+    return numCells - 1;
+}
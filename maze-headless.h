@@ -0,0 +1,305 @@
+/**
+ * File: maze-headless.h
+ * ---------------------
+ * Declares the maze generators that run without a MazeGeneratorView. They
+ * work on MazeBitplanes and identify cells and walls by index, so they can
+ * build mazes far larger than anything the window could display.
+ */
+
+#ifndef _maze_headless_
+#define _maze_headless_
+
+#include <cstdint>
+#include <vector>
+#include "maze-bitplanes.h"
+#include "maze-disjoint-set.h"
+#include "maze-morton.h"
+
+/*
+ * Type: MazeProgressFn
+ * --------------------
+ * A function the generators call now and then to report how far along they
+ * are. It receives a short name for the current phase and the fraction of
+ * that phase completed so far, from 0 to 1. Pass NULL to skip reporting.
+ */
+typedef void (*MazeProgressFn)(const char *phase, double fractionDone);
+
+/*
+ * Function: generateKruskalMaze
+ * Usage: uint64_t removed = generateKruskalMaze(maze, seed, wallsExamined, reportProgress);
+ * -------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze using the same
+ * adaptation of Kruskal's algorithm as the animated generator: every interior
+ * wall is listed, the list is shuffled, and each wall is removed if and only
+ * if it separates two distinct chambers. The result depends only on the size
+ * of the maze and the seed. Returns the number of walls removed.
+ *
+ * Walls stop being visited as soon as the maze is a single chamber, since no
+ * wall after that point can be removed. wallsExamined is set to the number of
+ * walls actually visited.
+ */
+uint64_t generateKruskalMaze(MazeBitplanes & maze, uint64_t seed, uint64_t & wallsExamined, MazeProgressFn progress);
+
+/*
+ * Type: kruskalScratch
+ * --------------------
+ * The wall list and disjoint-set structure generateKruskalMaze works in.
+ * Handing the same scratch to one call after another lets each call reuse the
+ * memory the last one allocated, which adds up when generating many small
+ * mazes. A scratch must not be shared between threads.
+ */
+struct kruskalScratch {
+    std::vector<uint64_t> walls;
+    DisjointSet chambers;
+};
+
+/*
+ * Function: generateKruskalMaze
+ * Usage: removed = generateKruskalMaze(maze, seed, wallsExamined, NULL, scratch, ROW_MAJOR_LAYOUT);
+ * -------------------------------------------------------------------------------------------------
+ * Generates exactly the same maze as the version above, working in scratch,
+ * with the disjoint-set structure numbering the cells in the given layout
+ * (see maze-morton.h).
+ */
+uint64_t generateKruskalMaze(MazeBitplanes & maze, uint64_t seed, uint64_t & wallsExamined, MazeProgressFn progress,
+                             kruskalScratch & scratch, MazeCellLayout layout);
+
+/*
+ * Function: generateParallelKruskalMaze
+ * Usage: removed = generateParallelKruskalMaze(maze, seed, numThreads, wallsExamined, reportProgress);
+ * ----------------------------------------------------------------------------------------------------
+ * Generates the same kind of maze as generateKruskalMaze using numThreads
+ * threads. Every wall is given a random weight, and the maze that results is
+ * exactly the one Kruskal's algorithm would produce by visiting the walls from
+ * lightest to heaviest. Random weights visit the walls in a uniformly random
+ * order, so these mazes follow the same distribution as the serial generator's.
+ * Like the serial generator, that distribution is NOT uniform over all
+ * spanning trees. Each wall's weight is computed from the seed and the wall's
+ * index alone, so the result depends only on the size of the maze and the
+ * seed: any number of threads builds exactly the same maze. Returns the
+ * number of walls removed, and sets wallsExamined to the number of walls
+ * visited by the strips and by the merge.
+ *
+ * The rows are split into one strip per thread. Each thread finds the spanning
+ * tree of its own strip, which throws out every wall that closes a cycle
+ * inside the strip. Those walls can never be removed in the full maze either.
+ * Each thread then shrinks its tree to the cells next to other strips and the
+ * cells where the tree branches, joined by paths of which only the heaviest
+ * wall can still be put back. The paths, along with the walls between strips,
+ * are then merged in weight order into one spanning tree, on a single thread
+ * but in time that grows with the width of the maze times the number of
+ * strips rather than with its area. With a single thread there is a single
+ * strip, whose tree is already the maze, so no merge is needed.
+ */
+uint64_t generateParallelKruskalMaze(MazeBitplanes & maze, uint64_t seed, int numThreads, uint64_t & wallsExamined,
+                                     MazeProgressFn progress);
+
+/*
+ * Function: generateConcurrentKruskalMaze
+ * Usage: removed = generateConcurrentKruskalMaze(maze, seed, numThreads, wallsExamined, reportProgress);
+ * -----------------------------------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze with Kruskal's
+ * algorithm, like generateKruskalMaze, but with numThreads threads visiting
+ * the shuffled walls at once through a lock-free disjoint-set structure (see
+ * ConcurrentDisjointSet in maze-disjoint-set.h). Every join of two chambers
+ * is made by exactly one thread's merge, and only that thread removes the
+ * wall, so no wall that closes a cycle ever comes down and the result is
+ * always a perfect maze. With one thread it is exactly the maze
+ * generateKruskalMaze builds from the same seed; with more, which walls come
+ * down depends on how the threads are scheduled, so the same seed can give
+ * different mazes. Returns the number of walls removed, and sets
+ * wallsExamined to the number of walls visited.
+ */
+uint64_t generateConcurrentKruskalMaze(MazeBitplanes & maze, uint64_t seed, int numThreads, uint64_t & wallsExamined,
+                                       MazeProgressFn progress);
+
+/*
+ * Function: concurrentKruskalMemoryEstimate
+ * Usage: uint64_t bytes = concurrentKruskalMemoryEstimate(width, height);
+ * -----------------------------------------------------------------------
+ * Returns roughly how many bytes generateConcurrentKruskalMaze needs for a
+ * maze of the given size, counting the maze itself.
+ */
+uint64_t concurrentKruskalMemoryEstimate(uint64_t width, uint64_t height);
+
+/*
+ * Type: MazeWeightFn
+ * ------------------
+ * A function that gives an interior wall its weight for
+ * generateWeightedKruskalMaze. It receives the seed, the wall's index (see
+ * makeWallIndex) and the row and column of the cell to its north or west,
+ * and must depend on nothing else, so that it can be called from any thread
+ * in any order. Lighter walls are considered first.
+ */
+typedef uint32_t (*MazeWeightFn)(uint64_t seed, uint64_t wallIndex, uint64_t row, uint64_t col);
+
+/*
+ * Functions: uniformWallWeight, corridorWallWeight, noiseWallWeight
+ * Usage: generateWeightedKruskalMaze(maze, seed, corridorWallWeight, numThreads, wallsExamined, NULL);
+ * ----------------------------------------------------------------------------------------------------
+ * Weight functions for generateWeightedKruskalMaze. uniformWallWeight gives
+ * every wall an independent random weight, which makes the same kind of maze
+ * as the other Kruskal generators. corridorWallWeight makes east walls
+ * lighter on average than south walls, which favours long east-west
+ * corridors. noiseWallWeight takes most of the weight from a smooth random
+ * field over the maze, so the maze is carved region by region, from the low
+ * ground of the field to the high.
+ */
+uint32_t uniformWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t row, uint64_t col);
+uint32_t corridorWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t row, uint64_t col);
+uint32_t noiseWallWeight(uint64_t seed, uint64_t wallIndex, uint64_t row, uint64_t col);
+
+/*
+ * Function: generateWeightedKruskalMaze
+ * Usage: removed = generateWeightedKruskalMaze(maze, seed, weightOf, numThreads, wallsExamined, reportProgress);
+ * --------------------------------------------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze by Kruskal's
+ * algorithm, visiting the walls in order of the weights that weightOf gives
+ * them, with ties going to the wall with the lower index. The weights are
+ * computed and sorted on numThreads threads, with a least-significant-digit
+ * radix sort that takes four linear passes over the walls however many there
+ * are. The result depends only on the size of the maze, the seed and the
+ * weight function. Returns the number of walls removed and sets
+ * wallsExamined to the number of walls visited.
+ */
+uint64_t generateWeightedKruskalMaze(MazeBitplanes & maze, uint64_t seed, MazeWeightFn weightOf, int numThreads,
+                                     uint64_t & wallsExamined, MazeProgressFn progress);
+
+/*
+ * Function: weightedKruskalMemoryEstimate
+ * Usage: uint64_t bytes = weightedKruskalMemoryEstimate(width, height);
+ * ---------------------------------------------------------------------
+ * Returns roughly how many bytes generateWeightedKruskalMaze needs for a maze
+ * of the given size, counting the maze itself.
+ */
+uint64_t weightedKruskalMemoryEstimate(uint64_t width, uint64_t height);
+
+/*
+ * Function: generateEllerMaze
+ * Usage: uint64_t rows = generateEllerMaze(width, height, seed, sink, reportProgress);
+ * -----------------------------------------------------------------------------------
+ * Generates a perfect maze of the given width one row at a time with Eller's
+ * algorithm, handing each row to sink as soon as it is finished. Only the row
+ * being built is ever held in memory, so memory use is O(width) no matter how
+ * tall the maze gets. The result depends only on the width, height and seed.
+ * Returns the number of rows handed to the sink.
+ *
+ * A height of 0 means the maze has no bottom. Rows are produced until the
+ * sink returns false. Every row produced so far is then part of one maze that
+ * continues downward. Any two cells already produced are connected, though
+ * possibly through rows that have not been produced yet.
+ */
+uint64_t generateEllerMaze(uint64_t width, uint64_t height, uint64_t seed, MazeRowSink & sink, MazeProgressFn progress);
+
+/*
+ * Function: ellerMemoryEstimate
+ * Usage: uint64_t bytes = ellerMemoryEstimate(width);
+ * ---------------------------------------------------
+ * Returns roughly how many bytes generateEllerMaze needs for a maze of the
+ * given width, not counting whatever the sink does with the rows.
+ */
+uint64_t ellerMemoryEstimate(uint64_t width);
+
+/*
+ * Function: generateWilsonMaze
+ * Usage: uint64_t removed = generateWilsonMaze(maze, seed, reportProgress);
+ * ------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze with Wilson's
+ * algorithm. Unlike the Kruskal generators, every possible perfect maze of
+ * the given size is equally likely. The maze grows from a random cell by
+ * loop-erased random walks: a walk starts at a cell outside the maze so far
+ * and wanders until it hits the maze. The path it took, with every loop
+ * erased, is then carved in. Needs about 3 bits per cell beyond the maze
+ * itself. Returns the number of walls removed.
+ */
+uint64_t generateWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress);
+
+/*
+ * Function: generateWilsonMaze
+ * Usage: removed = generateWilsonMaze(maze, seed, reportProgress, MORTON_LAYOUT);
+ * -------------------------------------------------------------------------------
+ * Generates exactly the same maze as the version above, with its working
+ * bitsets numbering the cells in the given layout (see maze-morton.h). The
+ * walks wander through the maze, so the Morton layout keeps more of their
+ * neighbourhood in cache.
+ */
+uint64_t generateWilsonMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress, MazeCellLayout layout);
+
+/*
+ * Function: wilsonMemoryEstimate
+ * Usage: uint64_t bytes = wilsonMemoryEstimate(width, height);
+ * ------------------------------------------------------------
+ * Returns roughly how many bytes generateWilsonMaze needs for a maze of the
+ * given size, counting the maze itself.
+ */
+uint64_t wilsonMemoryEstimate(uint64_t width, uint64_t height);
+
+/*
+ * Function: generateBacktrackerMaze
+ * Usage: uint64_t removed = generateBacktrackerMaze(maze, seed, reportProgress);
+ * -----------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze with the
+ * recursive backtracker. A path wanders from a random cell to random
+ * unvisited neighbours, carving as it goes; when it reaches a cell with no
+ * unvisited neighbours it backs up until it finds one that has. The result
+ * has long, winding corridors and few dead ends. The recursion is kept on an
+ * explicit stack of one byte per cell, allocated up front, so there is no
+ * limit on the size of the maze beyond memory. Returns the number of walls
+ * removed.
+ */
+uint64_t generateBacktrackerMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress);
+
+/*
+ * Function: generateHuntAndKillMaze
+ * Usage: uint64_t removed = generateHuntAndKillMaze(maze, seed, reportProgress);
+ * -----------------------------------------------------------------------------
+ * Turns a maze with every wall standing into a perfect maze with the
+ * hunt-and-kill algorithm. A walk carves to random unvisited neighbours, like
+ * the recursive backtracker, but when it gets stuck it does not back up: it
+ * hunts, row by row, for the first unvisited cell next to the maze, joins it
+ * on, and walks again from there. Needs no stack, only a bit per cell beyond
+ * the maze itself. Returns the number of walls removed.
+ */
+uint64_t generateHuntAndKillMaze(MazeBitplanes & maze, uint64_t seed, MazeProgressFn progress);
+
+/*
+ * Functions: backtrackerMemoryEstimate, huntAndKillMemoryEstimate
+ * Usage: uint64_t bytes = backtrackerMemoryEstimate(width, height);
+ * -----------------------------------------------------------------
+ * Return roughly how many bytes generateBacktrackerMaze and
+ * generateHuntAndKillMaze need for a maze of the given size, counting the
+ * maze itself.
+ */
+uint64_t backtrackerMemoryEstimate(uint64_t width, uint64_t height);
+uint64_t huntAndKillMemoryEstimate(uint64_t width, uint64_t height);
+
+/*
+ * Class: BitplanesRowSink
+ * -----------------------
+ * A MazeRowSink that copies the rows it receives into a MazeBitplanes of the
+ * same width, so a streaming generator can also build a maze in memory. Rows
+ * past the bottom of the maze are refused.
+ */
+class BitplanesRowSink : public MazeRowSink {
+public:
+    explicit BitplanesRowSink(MazeBitplanes & maze);
+    bool acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords);
+
+private:
+    MazeBitplanes & destination;
+};
+
+/*
+ * Functions: kruskalMemoryEstimate, parallelKruskalMemoryEstimate
+ * Usage: uint64_t bytes = parallelKruskalMemoryEstimate(width, height);
+ * ---------------------------------------------------------------------
+ * Return roughly how many bytes generateKruskalMaze or
+ * generateParallelKruskalMaze needs for a maze of the given size, counting
+ * the maze itself along with the wall lists and the disjoint-set structures
+ * it uses while running. The parallel generator needs the same memory for
+ * any number of threads, since its strips split the same walls between them.
+ */
+uint64_t kruskalMemoryEstimate(uint64_t width, uint64_t height);
+uint64_t parallelKruskalMemoryEstimate(uint64_t width, uint64_t height);
+
+#endif
@@ -0,0 +1,457 @@
+/**
+ * File: maze-image.cpp
+ * --------------------
+ * Implements the maze image writer declared in maze-image.h.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+using namespace std;
+
+#include "maze-image.h"
+
+/*
+ * Type: codeTables
+ * ----------------
+ * Lookup tables shared by every writer: each byte with its bits reversed, the CRC-32 of each byte for PNG chunks, and the
+ * fixed Huffman codes of deflate (RFC 1951) for every literal byte and for every run that repeats the previous byte 3 to 258
+ * times. Codes are stored with their bits in the order they are written.
+ */
+struct codeTables {
+    uint8_t reversedBytes[256];
+    uint32_t crcTable[256];
+    uint32_t literalBits[257];
+    uint8_t literalBitCounts[257];
+    uint32_t runBits[259];
+    uint8_t runBitCounts[259];
+    codeTables();
+};
+
+//Prototypes
+static uint32_t reverseBits(uint32_t code, int numBits);
+static uint32_t updateCrc(uint32_t crc, const uint8_t *bytes, uint64_t count);
+static void putBigEndian(uint8_t *bytes, uint32_t value);
+static const codeTables tables;
+static const size_t maxQueuedBlocks = 4;
+static const size_t compressedChunkBytes = 1 << 20;
+static const uint32_t adlerModulus = 65521;
+static const uint64_t adlerBlockBytes = 5552;
+static const uint64_t maxPngDimension = 0x7fffffff;
+static const int pbmHeightDigits = 20;
+static const uint8_t pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+static const uint8_t upFilter = 2;
+static const int endOfBlock = 256;
+static const int fixedBlockHeader = 2;
+static const int finalFixedBlockHeader = 3;
+
+MazeImageWriter::MazeImageWriter() {
+    threaded = false;
+    finished = false;
+    writeFailed = false;
+}
+
+MazeImageWriter::~MazeImageWriter() {
+    if (file.is_open()) close();
+}
+
+/*
+ * Each pattern covers cellsPerPattern cells, as many as fit in one word of pixels up to a byte's worth, and is indexed by their
+ * walls. An east pattern has a black pixel at the end of every cell whose east wall is up. A south pattern has a black corner
+ * post at the end of every cell, and a black line across every cell whose south wall is up. A PNG starts with a zlib header
+ * and opens a single deflate block with fixed codes, which close ends.
+ */
+bool MazeImageWriter::open(const string & filename, MazeImageFormat format, uint64_t width, int pixelsPerCell,
+                           bool useWriterThread) {
+    if (file.is_open()) close();
+    if (pixelsPerCell < kMinPixelsPerCell || pixelsPerCell > kMaxPixelsPerCell || width == 0) return false;
+    imageFormat = format;
+    cellPixels = pixelsPerCell;
+    mazeWidth = width;
+    imageWidth = width * pixelsPerCell + 1;
+    imageHeight = 1;
+    rowBytes = (imageWidth + 7) / 8;
+    if (format == PNG_IMAGE && imageWidth > maxPngDimension) return false;
+
+    cellsPerPattern = min(8, 64 / pixelsPerCell);
+    eastPatterns.assign(1 << cellsPerPattern, 0);
+    southPatterns.assign(1 << cellsPerPattern, 0);
+    for (int walls = 0; walls < (1 << cellsPerPattern); walls++) {
+        for (int cell = 0; cell < cellsPerPattern; cell++) {
+            uint64_t corner = 1ULL << (cell * pixelsPerCell + pixelsPerCell - 1);
+            southPatterns[walls] |= corner;
+            if ((walls >> cell) & 1) {
+                eastPatterns[walls] |= corner;
+                southPatterns[walls] |= corner - (1ULL << (cell * pixelsPerCell));
+            }
+        }
+    }
+    pixelWords.assign((imageWidth + 63) / 64 + 1, 0);
+
+    file.open(filename.c_str(), ios::binary | ios::trunc);
+    if (file.fail()) return false;
+    if (format == PBM_IMAGE) {
+        file << "P4\n" << imageWidth << " ";
+        heightPosition = file.tellp();
+        file << setw(pbmHeightDigits) << imageHeight << "\n";
+    } else {
+        file.write((const char *) pngSignature, sizeof(pngSignature));
+        heightPosition = file.tellp();
+        uint8_t header[13] = { 0 };
+        putBigEndian(header, imageWidth);
+        putBigEndian(header + 4, imageHeight);
+        header[8] = 1;
+        writeChunk("IHDR", header, sizeof(header));
+        previousRow.assign(rowBytes, 0);
+        filteredRow.assign(rowBytes + 1, upFilter);
+        compressed.clear();
+        compressed.push_back(0x78);
+        compressed.push_back(0x01);
+        bitBuffer = 0;
+        bitCount = 0;
+        adlerLow = 1;
+        adlerHigh = 0;
+        putBits(fixedBlockHeader, 3);
+    }
+
+    finished = false;
+    writeFailed = file.fail();
+    fullBlocks.clear();
+    threaded = useWriterThread;
+    if (threaded) writerThread = thread(&MazeImageWriter::runWriterThread, this);
+    vector<uint8_t> border(rowBytes, format == PBM_IMAGE ? 0xff : 0x00);
+    submitBlock(border);
+    return !writeFailed;
+}
+
+/*
+ * The cell's square is p - 1 identical rows of passage and east walls followed by one row of south walls and corner posts, so
+ * only two rows of pixels are rendered per row of the maze.
+ */
+void MazeImageWriter::writeRow(const uint64_t *eastWords, const uint64_t *southWords) {
+    vector<uint8_t> block;
+    {
+        lock_guard<mutex> lock(queueLock);
+        if (!emptyBlocks.empty()) {
+            block.swap(emptyBlocks.back());
+            emptyBlocks.pop_back();
+        }
+    }
+    block.resize(cellPixels * rowBytes);
+    renderPixelRow(eastWords, eastPatterns, block.data());
+    for (int i = 1; i < cellPixels - 1; i++) {
+        memcpy(block.data() + i * rowBytes, block.data(), rowBytes);
+    }
+    renderPixelRow(southWords, southPatterns, block.data() + (cellPixels - 1) * rowBytes);
+    imageHeight += cellPixels;
+    submitBlock(block);
+}
+
+bool MazeImageWriter::acceptRow(uint64_t, const uint64_t *eastWords, const uint64_t *southWords) {
+    writeRow(eastWords, southWords);
+    lock_guard<mutex> lock(queueLock);
+    return !writeFailed;
+}
+
+/*
+ * Once the writer thread has drained the queue, a PNG's deflate block is ended and followed by an empty final block, then the
+ * Adler-32 checksum that ends the zlib stream. The height in the header is only known now, so the header is written again.
+ */
+bool MazeImageWriter::close() {
+    if (threaded) {
+        {
+            lock_guard<mutex> lock(queueLock);
+            finished = true;
+        }
+        queueChanged.notify_all();
+        writerThread.join();
+        threaded = false;
+    }
+    bool succeeded = !writeFailed;
+    if (imageFormat == PBM_IMAGE) {
+        file.seekp(heightPosition);
+        file << setw(pbmHeightDigits) << imageHeight;
+    } else {
+        putLiteral(endOfBlock);
+        putBits(finalFixedBlockHeader, 3);
+        putLiteral(endOfBlock);
+        if (bitCount > 0) putBits(0, 8 - bitCount);
+        uint8_t adler[4];
+        putBigEndian(adler, (adlerHigh << 16) | adlerLow);
+        compressed.insert(compressed.end(), adler, adler + 4);
+        flushCompressed(true);
+        writeChunk("IEND", NULL, 0);
+        if (imageHeight > maxPngDimension) succeeded = false;
+        file.seekp(heightPosition);
+        uint8_t header[13] = { 0 };
+        putBigEndian(header, imageWidth);
+        putBigEndian(header + 4, imageHeight);
+        header[8] = 1;
+        writeChunk("IHDR", header, sizeof(header));
+    }
+    succeeded = succeeded && !file.fail();
+    file.close();
+    return succeeded && !file.fail();
+}
+
+bool exportMazeImage(const MazeBitplanes & maze, const string & filename, MazeImageFormat format, int pixelsPerCell,
+                     bool useWriterThread) {
+    MazeImageWriter writer;
+    if (!writer.open(filename, format, maze.width(), pixelsPerCell, useWriterThread)) return false;
+    for (uint64_t row = 0; row < maze.height(); row++) {
+        writer.writeRow(maze.eastRow(row), maze.southRow(row));
+    }
+    return writer.close();
+}
+
+/*
+ * This method renders one row of pixels from one row of walls. The pattern for each group of cells is shifted into place in a
+ * row of 64-bit words, after the pixel for the left border, and the words are then packed into bytes with the leftmost pixel
+ * in the high bit, as both formats expect. PBM uses 1 for black and PNG uses 0.
+ */
+void MazeImageWriter::renderPixelRow(const uint64_t *words, const vector<uint64_t> & patterns, uint8_t *pixels) {
+    fill(pixelWords.begin(), pixelWords.end(), 0);
+    pixelWords[0] = 1;
+    uint64_t pixel = 1;
+    for (uint64_t col = 0; col < mazeWidth; col += cellsPerPattern) {
+        uint64_t cells = min((uint64_t) cellsPerPattern, mazeWidth - col);
+        uint64_t walls = words[col / 64] >> (col % 64);
+        if (col % 64 + cells > 64) walls |= words[col / 64 + 1] << (64 - col % 64);
+        uint64_t pattern = patterns[walls & ((1ULL << cells) - 1)];
+        uint64_t numPixels = cells * cellPixels;
+        if (numPixels < 64) pattern &= (1ULL << numPixels) - 1;
+        pixelWords[pixel / 64] |= pattern << (pixel % 64);
+        if (pixel % 64 + numPixels > 64) pixelWords[pixel / 64 + 1] |= pattern >> (64 - pixel % 64);
+        pixel += numPixels;
+    }
+    uint8_t black = imageFormat == PBM_IMAGE ? 0x00 : 0xff;
+    for (uint64_t i = 0; i < rowBytes; i++) {
+        pixels[i] = tables.reversedBytes[(pixelWords[i / 8] >> (8 * (i % 8))) & 0xff] ^ black;
+    }
+}
+
+/*
+ * This method hands a block of rendered rows to the writer thread, waiting while the queue is full so the memory used stays
+ * bounded, or writes it straight away if there is no writer thread. The block is left empty.
+ */
+void MazeImageWriter::submitBlock(vector<uint8_t> & block) {
+    if (!threaded) {
+        writeBlock(block);
+        lock_guard<mutex> lock(queueLock);
+        emptyBlocks.push_back(vector<uint8_t>());
+        emptyBlocks.back().swap(block);
+        return;
+    }
+    {
+        unique_lock<mutex> lock(queueLock);
+        queueChanged.wait(lock, [this] { return fullBlocks.size() < maxQueuedBlocks; });
+        fullBlocks.push_back(vector<uint8_t>());
+        fullBlocks.back().swap(block);
+    }
+    queueChanged.notify_all();
+}
+
+/*
+ * This method writes every row of pixels in a block to the file, compressing them first for PNG.
+ */
+void MazeImageWriter::writeBlock(const vector<uint8_t> & block) {
+    if (imageFormat == PBM_IMAGE) {
+        file.write((const char *) block.data(), block.size());
+    } else {
+        for (uint64_t offset = 0; offset < block.size(); offset += rowBytes) {
+            compressRow(block.data() + offset);
+        }
+    }
+    if (file.fail()) {
+        lock_guard<mutex> lock(queueLock);
+        writeFailed = true;
+    }
+}
+
+/*
+ * This method is the body of the writer thread. It writes blocks in the order they were submitted, and returns once the
+ * writer is closed and the queue is empty.
+ */
+void MazeImageWriter::runWriterThread() {
+    while (true) {
+        vector<uint8_t> block;
+        {
+            unique_lock<mutex> lock(queueLock);
+            queueChanged.wait(lock, [this] { return !fullBlocks.empty() || finished; });
+            if (fullBlocks.empty()) return;
+            block.swap(fullBlocks.front());
+            fullBlocks.pop_front();
+        }
+        queueChanged.notify_all();
+        writeBlock(block);
+        lock_guard<mutex> lock(queueLock);
+        emptyBlocks.push_back(vector<uint8_t>());
+        emptyBlocks.back().swap(block);
+    }
+}
+
+/*
+ * This method adds one row of pixels to a PNG's compressed data. The row is stored with PNG's "up" filter, as its difference
+ * from the row above. Most rows of a maze repeat or nearly repeat the row above, so the filtered row is mostly zeros.
+ */
+void MazeImageWriter::compressRow(const uint8_t *row) {
+    for (uint64_t i = 0; i < rowBytes; i++) {
+        filteredRow[i + 1] = row[i] - previousRow[i];
+    }
+    memcpy(previousRow.data(), row, rowBytes);
+    const uint8_t *bytes = filteredRow.data();
+    for (uint64_t start = 0; start <= rowBytes; start += adlerBlockBytes) {
+        uint64_t end = min(start + adlerBlockBytes, rowBytes + 1);
+        for (uint64_t i = start; i < end; i++) {
+            adlerLow += bytes[i];
+            adlerHigh += adlerLow;
+        }
+        adlerLow %= adlerModulus;
+        adlerHigh %= adlerModulus;
+    }
+    compressBytes(bytes, rowBytes + 1);
+    flushCompressed(false);
+}
+
+/*
+ * This method compresses bytes with the only kind of match the writer looks for: a run of one repeated byte, coded as the
+ * byte followed by copies from one byte back. Runs are found eight bytes at a time.
+ */
+void MazeImageWriter::compressBytes(const uint8_t *bytes, uint64_t count) {
+    uint64_t i = 0;
+    while (i < count) {
+        uint8_t value = bytes[i];
+        uint64_t repeated = value * 0x0101010101010101ULL;
+        uint64_t end = i + 1;
+        while (end + 8 <= count) {
+            uint64_t word;
+            memcpy(&word, bytes + end, sizeof(word));
+            if (word != repeated) break;
+            end += 8;
+        }
+        while (end < count && bytes[end] == value) end++;
+        putLiteral(value);
+        uint64_t remaining = end - i - 1;
+        while (remaining >= 3) {
+            uint64_t length = min(remaining, (uint64_t) 258);
+            putRun(length);
+            remaining -= length;
+        }
+        for (; remaining > 0; remaining--) putLiteral(value);
+        i = end;
+    }
+}
+
+/*
+ * This method appends bits to the compressed data, least significant bit first.
+ */
+void MazeImageWriter::putBits(uint64_t bits, int numBits) {
+    bitBuffer |= bits << bitCount;
+    bitCount += numBits;
+    while (bitCount >= 8) {
+        compressed.push_back(bitBuffer & 0xff);
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void MazeImageWriter::putLiteral(int literal) {
+    putBits(tables.literalBits[literal], tables.literalBitCounts[literal]);
+}
+
+void MazeImageWriter::putRun(uint64_t length) {
+    putBits(tables.runBits[length], tables.runBitCounts[length]);
+}
+
+/*
+ * This method writes the compressed data gathered so far as an IDAT chunk once there is enough of it, or whatever there is
+ * if force is true.
+ */
+void MazeImageWriter::flushCompressed(bool force) {
+    if (compressed.size() < compressedChunkBytes && !(force && !compressed.empty())) return;
+    writeChunk("IDAT", compressed.data(), compressed.size());
+    compressed.clear();
+}
+
+/*
+ * This method writes a PNG chunk: its length, its four-letter type, its data, and the CRC-32 of the type and data.
+ */
+void MazeImageWriter::writeChunk(const char *type, const uint8_t *data, uint64_t length) {
+    uint8_t prefix[8];
+    putBigEndian(prefix, length);
+    memcpy(prefix + 4, type, 4);
+    uint32_t crc = updateCrc(0xffffffff, prefix + 4, 4);
+    crc = updateCrc(crc, data, length) ^ 0xffffffff;
+    uint8_t suffix[4];
+    putBigEndian(suffix, crc);
+    file.write((const char *) prefix, sizeof(prefix));
+    if (length > 0) file.write((const char *) data, length);
+    file.write((const char *) suffix, sizeof(suffix));
+}
+
+/*
+ * Literals and runs use the fixed codes of RFC 1951, section 3.2.6. A run of length n is the length code for n with its extra
+ * bits, then distance code 0, which means one byte back.
+ */
+codeTables::codeTables() {
+    for (int i = 0; i < 256; i++) {
+        reversedBytes[i] = reverseBits(i, 8);
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+        }
+        crcTable[i] = crc;
+    }
+    for (int symbol = 0; symbol <= 256; symbol++) {
+        if (symbol < 144) {
+            literalBits[symbol] = reverseBits(0x30 + symbol, 8);
+            literalBitCounts[symbol] = 8;
+        } else if (symbol < 256) {
+            literalBits[symbol] = reverseBits(0x190 + symbol - 144, 9);
+            literalBitCounts[symbol] = 9;
+        } else {
+            literalBits[symbol] = 0;
+            literalBitCounts[symbol] = 7;
+        }
+    }
+    static const int lengthBases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+                                         99, 115, 131, 163, 195, 227, 258 };
+    static const int lengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5,
+                                             5, 5, 0 };
+    for (int code = 0; code < 29; code++) {
+        int symbol = 257 + code;
+        uint32_t symbolBits = symbol < 280 ? reverseBits(symbol - 256, 7) : reverseBits(0xc0 + symbol - 280, 8);
+        int symbolBitCount = symbol < 280 ? 7 : 8;
+        for (int extra = 0; extra < (1 << lengthExtraBits[code]) && lengthBases[code] + extra <= 258; extra++) {
+            int length = lengthBases[code] + extra;
+            runBits[length] = symbolBits | (extra << symbolBitCount);
+            runBitCounts[length] = symbolBitCount + lengthExtraBits[code] + 5;
+        }
+    }
+}
+
+/*
+ * This method returns the low numBits bits of code in reverse order, since deflate writes Huffman codes starting from their
+ * most significant bit.
+ */
+static uint32_t reverseBits(uint32_t code, int numBits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < numBits; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    return reversed;
+}
+
+static uint32_t updateCrc(uint32_t crc, const uint8_t *bytes, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        crc = tables.crcTable[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void putBigEndian(uint8_t *bytes, uint32_t value) {
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
@@ -0,0 +1,168 @@
+/**
+ * File: maze-image.h
+ * ------------------
+ * Defines a writer that renders a maze, a row at a time, into a black and
+ * white PBM or PNG image, for mazes far too large for MazeGeneratorView.
+ *
+ * Every cell is a square of pixelsPerCell pixels, whose last column holds the
+ * cell's east wall and whose last row holds its south wall and the post at
+ * its south-east corner. A single line of pixels down the left and across the
+ * top closes the border, so a width-by-height maze makes an image
+ * width * pixelsPerCell + 1 pixels wide and height * pixelsPerCell + 1 tall.
+ * Walls are black and passages white.
+ */
+
+#ifndef _maze_image_
+#define _maze_image_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "maze-bitplanes.h"
+
+/*
+ * Type: MazeImageFormat
+ * ---------------------
+ * The kinds of image a MazeImageWriter can write. PBM images are stored one
+ * bit per pixel with no compression. PNG images are one bit per pixel as
+ * well, and compressed.
+ */
+enum MazeImageFormat {
+    PBM_IMAGE,
+    PNG_IMAGE
+};
+
+/*
+ * Constants: kMinPixelsPerCell, kMaxPixelsPerCell
+ * -----------------------------------------------
+ * The range of cell sizes a MazeImageWriter can draw. A cell needs at least
+ * one pixel of passage and one of wall.
+ */
+static const int kMinPixelsPerCell = 2;
+static const int kMaxPixelsPerCell = 64;
+
+/*
+ * Class: MazeImageWriter
+ * ----------------------
+ * Writes a maze image one maze row at a time, so a generator can hand each
+ * row over as soon as it is final and neither the maze nor the image is ever
+ * held in memory. Only a few rows of pixels are buffered at once, however
+ * large the image. The height is filled into the image header when the writer
+ * is closed. As a MazeRowSink, a writer can be handed straight to a streaming
+ * generator.
+ *
+ * Rows of pixels are rendered from the bitplanes a byte of walls at a time,
+ * by looking up the pixels for eight cells in a table built when the writer is
+ * opened. Writing, and for PNG compressing, the rendered pixels can be handed
+ * to a thread of its own, so that rendering the next row overlaps it.
+ */
+class MazeImageWriter : public MazeRowSink {
+public:
+    MazeImageWriter();
+    ~MazeImageWriter();
+
+    /*
+     * Method: open
+     * Usage: if (writer.open(filename, PNG_IMAGE, width, pixelsPerCell, true)) ...
+     * ----------------------------------------------------------------------------
+     * Creates the image file, writes a provisional header and the top border,
+     * and, if useWriterThread is true, starts the thread that writes the rest.
+     * Returns false if the file cannot be created, or if the width or
+     * pixelsPerCell is out of range for the format.
+     */
+    bool open(const std::string & filename, MazeImageFormat format, uint64_t width, int pixelsPerCell,
+              bool useWriterThread);
+
+    /*
+     * Method: writeRow
+     * Usage: writer.writeRow(maze.eastRow(row), maze.southRow(row));
+     * --------------------------------------------------------------
+     * Renders the next row of the maze, given its east and south words.
+     */
+    void writeRow(const uint64_t *eastWords, const uint64_t *southWords);
+
+    /*
+     * Method: acceptRow
+     * Usage: generateEllerMaze(width, height, seed, writer, NULL);
+     * ------------------------------------------------------------
+     * Renders the row as writeRow does. Returns false once writing fails.
+     */
+    bool acceptRow(uint64_t row, const uint64_t *eastWords, const uint64_t *southWords);
+
+    /*
+     * Method: close
+     * Usage: if (writer.close()) ...
+     * ------------------------------
+     * Waits for every row to be written, completes the image and closes the
+     * file. Returns false if anything written since open failed to reach the
+     * disk.
+     */
+    bool close();
+
+private:
+    std::ofstream file;
+    MazeImageFormat imageFormat;
+    int cellPixels;
+    uint64_t mazeWidth;
+    uint64_t imageWidth;
+    uint64_t imageHeight;
+    uint64_t rowBytes;
+    std::streampos heightPosition;
+
+    /* Rendering */
+    int cellsPerPattern;
+    std::vector<uint64_t> eastPatterns;
+    std::vector<uint64_t> southPatterns;
+    std::vector<uint64_t> pixelWords;
+
+    /* Handing rendered rows to the writer thread */
+    bool threaded;
+    std::thread writerThread;
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<std::vector<uint8_t> > fullBlocks;
+    std::vector<std::vector<uint8_t> > emptyBlocks;
+    bool finished;
+    bool writeFailed;
+
+    /* PNG compression */
+    std::vector<uint8_t> previousRow;
+    std::vector<uint8_t> filteredRow;
+    std::vector<uint8_t> compressed;
+    uint64_t bitBuffer;
+    int bitCount;
+    uint32_t adlerLow;
+    uint32_t adlerHigh;
+
+    void renderPixelRow(const uint64_t *words, const std::vector<uint64_t> & patterns, uint8_t *pixels);
+    void submitBlock(std::vector<uint8_t> & block);
+    void writeBlock(const std::vector<uint8_t> & block);
+    void runWriterThread();
+    void compressRow(const uint8_t *row);
+    void compressBytes(const uint8_t *bytes, uint64_t count);
+    void putBits(uint64_t bits, int numBits);
+    void putLiteral(int literal);
+    void putRun(uint64_t length);
+    void flushCompressed(bool force);
+    void writeChunk(const char *type, const uint8_t *data, uint64_t length);
+
+    MazeImageWriter(const MazeImageWriter & src);
+    MazeImageWriter & operator=(const MazeImageWriter & src);
+};
+
+/*
+ * Function: exportMazeImage
+ * Usage: if (exportMazeImage(maze, filename, PNG_IMAGE, pixelsPerCell, true)) ...
+ * -------------------------------------------------------------------------------
+ * Renders a maze that is already in memory to an image file. Returns false if
+ * the file could not be written.
+ */
+bool exportMazeImage(const MazeBitplanes & maze, const std::string & filename, MazeImageFormat format,
+                     int pixelsPerCell, bool useWriterThread);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * File: maze-instrumentation.cpp
+ * ------------------------------
+ * Implements the counters, phase timers and JSON export declared in
+ * maze-instrumentation.h. Compiles to nothing unless MAZE_INSTRUMENTATION is
+ * defined.
+ */
+
+#include "maze-instrumentation.h"
+
+#ifdef MAZE_INSTRUMENTATION
+
+#include <iomanip>
+#include <sstream>
+using namespace std;
+
+//Prototypes
+static double ratioOf(uint64_t numerator, uint64_t denominator);
+static const char *counterNames[NUM_MAZE_COUNTERS] = {
+    "wallsExamined", "wallsRemoved", "setFinds", "setFindSteps", "setUnions", "drawCalls", "repaints"
+};
+static const char *phaseNames[NUM_MAZE_PHASES] = { "initializeWalls", "shuffleWalls", "removeWalls", "draw" };
+
+mazeInstrumentation gMazeInstrumentation;
+
+void resetMazeInstrumentation() {
+    for (int i = 0; i < NUM_MAZE_COUNTERS; i++) {
+        gMazeInstrumentation.counters[i].store(0);
+    }
+    for (int i = 0; i < NUM_MAZE_PHASES; i++) {
+        gMazeInstrumentation.phaseNanoseconds[i].store(0);
+        gMazeInstrumentation.phaseEntries[i].store(0);
+    }
+}
+
+/*
+ * The object has a "counters" object keyed by counter name, a "phases" object holding the seconds spent in and number of
+ * entries to each phase, and the two derived ratios. Every name is a fixed identifier, so nothing needs escaping.
+ */
+string mazeInstrumentationJson() {
+    uint64_t counters[NUM_MAZE_COUNTERS];
+    for (int i = 0; i < NUM_MAZE_COUNTERS; i++) {
+        counters[i] = gMazeInstrumentation.counters[i].load();
+    }
+    ostringstream json;
+    json << setprecision(9) << "{\n  \"counters\": {";
+    for (int i = 0; i < NUM_MAZE_COUNTERS; i++) {
+        json << (i == 0 ? "\n" : ",\n") << "    \"" << counterNames[i] << "\": " << counters[i];
+    }
+    json << "\n  },\n  \"phases\": {";
+    for (int i = 0; i < NUM_MAZE_PHASES; i++) {
+        json << (i == 0 ? "\n" : ",\n") << "    \"" << phaseNames[i] << "\": { \"seconds\": "
+             << gMazeInstrumentation.phaseNanoseconds[i].load() / 1e9 << ", \"entries\": "
+             << gMazeInstrumentation.phaseEntries[i].load() << " }";
+    }
+    json << "\n  },\n  \"averageFindPathLength\": " << ratioOf(counters[SET_FIND_STEPS], counters[SET_FINDS])
+         << ",\n  \"fractionOfWallsRemoved\": " << ratioOf(counters[WALLS_REMOVED], counters[WALLS_EXAMINED]) << "\n}\n";
+    return json.str();
+}
+
+/*
+ * Returns numerator / denominator, or 0 when nothing was counted, since JSON has no way to write NaN.
+ */
+static double ratioOf(uint64_t numerator, uint64_t denominator) {
+    return denominator == 0 ? 0 : (double) numerator / denominator;
+}
+
+#endif
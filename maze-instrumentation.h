@@ -0,0 +1,138 @@
+/**
+ * File: maze-instrumentation.h
+ * ----------------------------
+ * Defines counters and phase timers that show where the time of maze
+ * generation goes, and a way to export them as JSON.
+ *
+ * Everything here is compiled in only when MAZE_INSTRUMENTATION is defined
+ * (for example with -DMAZE_INSTRUMENTATION). Otherwise the macros below
+ * expand to nothing and their arguments are never evaluated, so instrumented
+ * code is exactly as fast as it was before it was instrumented.
+ */
+
+#ifndef _maze_instrumentation_
+#define _maze_instrumentation_
+
+#ifdef MAZE_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+ * Type: MazeCounter
+ * -----------------
+ * The events that are counted. setFindSteps counts the parent links followed
+ * by every find of a disjoint-set structure, so setFindSteps / setFinds is the
+ * average length of the paths walked to reach a representative.
+ */
+enum MazeCounter {
+    WALLS_EXAMINED,
+    WALLS_REMOVED,
+    SET_FINDS,
+    SET_FIND_STEPS,
+    SET_UNIONS,
+    DRAW_CALLS,
+    REPAINTS,
+    NUM_MAZE_COUNTERS
+};
+
+/*
+ * Type: MazePhase
+ * ---------------
+ * The phases of generation that are timed: building the list of walls,
+ * shuffling it, removing the walls that separate chambers, and drawing.
+ */
+enum MazePhase {
+    INITIALIZE_WALLS_PHASE,
+    SHUFFLE_PHASE,
+    REMOVE_WALLS_PHASE,
+    DRAW_PHASE,
+    NUM_MAZE_PHASES
+};
+
+/*
+ * Type: mazeInstrumentation
+ * -------------------------
+ * Every counter and the time spent in, and number of entries to, every phase.
+ * The fields are atomic so the threads of the parallel generators and the
+ * maze farm can all add to them; time spent in a phase is summed over every
+ * thread, so it can exceed the time the whole run took.
+ */
+struct mazeInstrumentation {
+    std::atomic<uint64_t> counters[NUM_MAZE_COUNTERS];
+    std::atomic<uint64_t> phaseNanoseconds[NUM_MAZE_PHASES];
+    std::atomic<uint64_t> phaseEntries[NUM_MAZE_PHASES];
+};
+
+extern mazeInstrumentation gMazeInstrumentation;
+
+/*
+ * Function: resetMazeInstrumentation
+ * Usage: resetMazeInstrumentation();
+ * ----------------------------------
+ * Sets every counter and phase time back to zero.
+ */
+void resetMazeInstrumentation();
+
+/*
+ * Function: mazeInstrumentationJson
+ * Usage: string json = mazeInstrumentationJson();
+ * -----------------------------------------------
+ * Returns every counter and phase time as a JSON object, along with the
+ * average find path length and the fraction of walls examined that were
+ * removed.
+ */
+std::string mazeInstrumentationJson();
+
+/*
+ * Class: MazePhaseTimer
+ * ---------------------
+ * Adds the time from its construction to its destruction to a phase. Use it
+ * through MAZE_TIME_PHASE rather than directly.
+ */
+class MazePhaseTimer {
+public:
+    explicit MazePhaseTimer(MazePhase phase);
+    ~MazePhaseTimer();
+
+private:
+    MazePhase timedPhase;
+    std::chrono::steady_clock::time_point start;
+};
+
+inline MazePhaseTimer::MazePhaseTimer(MazePhase phase) {
+    timedPhase = phase;
+    start = std::chrono::steady_clock::now();
+}
+
+inline MazePhaseTimer::~MazePhaseTimer() {
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    gMazeInstrumentation.phaseNanoseconds[timedPhase].fetch_add(elapsed, std::memory_order_relaxed);
+    gMazeInstrumentation.phaseEntries[timedPhase].fetch_add(1, std::memory_order_relaxed);
+}
+
+#define MAZE_JOIN_NAMES(one, two) one##two
+#define MAZE_TIMER_NAME(line) MAZE_JOIN_NAMES(mazePhaseTimer, line)
+
+/*
+ * Macros: MAZE_COUNT, MAZE_TIME_PHASE
+ * Usage: MAZE_COUNT(WALLS_EXAMINED, 1);
+ *        MAZE_TIME_PHASE(SHUFFLE_PHASE);
+ * --------------------------------------
+ * MAZE_COUNT adds amount to a counter. MAZE_TIME_PHASE times the rest of the
+ * enclosing block as part of a phase.
+ */
+#define MAZE_COUNT(counter, amount) \
+    gMazeInstrumentation.counters[counter].fetch_add(amount, std::memory_order_relaxed)
+#define MAZE_TIME_PHASE(phase) MazePhaseTimer MAZE_TIMER_NAME(__LINE__)(phase)
+
+#else
+
+#define MAZE_COUNT(counter, amount) ((void) 0)
+#define MAZE_TIME_PHASE(phase) ((void) 0)
+
+#endif
+
+#endif
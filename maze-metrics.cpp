@@ -0,0 +1,186 @@
+/**
+ * File: maze-metrics.cpp
+ * ----------------------
+ * Implements the maze measurements declared in maze-metrics.h.
+ */
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "maze-metrics.h"
+#include "maze-solver.h"
+
+/*
+ * Type: rowBand
+ * -------------
+ * A band of consecutive rows counted by one thread, along with the counts it found.
+ */
+struct rowBand {
+    uint64_t firstRow;
+    uint64_t endRow;
+    uint64_t deadEnds;
+    uint64_t junctions;
+};
+
+//Prototypes
+static void countBandOpenings(const MazeBitplanes & maze, rowBand & band);
+static uint64_t findFarthestCell(const MazeBitplanes & maze, uint64_t start, uint64_t & distance);
+static uint64_t countTurns(const string & path);
+static uint64_t validCellMask(uint64_t width, uint64_t word);
+
+mazeMetrics measureMaze(const MazeBitplanes & maze, int numThreads) {
+    mazeMetrics metrics = mazeMetrics();
+    metrics.width = maze.width();
+    metrics.height = maze.height();
+    if (maze.numCells() == 0) return metrics;
+
+    uint64_t numBands = numThreads < 1 ? 1 : numThreads;
+    if (numBands > maze.height()) numBands = maze.height();
+    vector<rowBand> bands(numBands);
+    vector<thread> workers;
+    for (uint64_t i = 0; i < numBands; i++) {
+        bands[i].firstRow = maze.height() * i / numBands;
+        bands[i].endRow = maze.height() * (i + 1) / numBands;
+        bands[i].deadEnds = 0;
+        bands[i].junctions = 0;
+        if (i > 0) workers.push_back(thread(countBandOpenings, cref(maze), ref(bands[i])));
+    }
+    countBandOpenings(maze, bands[0]);
+    for (thread & worker : workers) {
+        worker.join();
+    }
+    for (const rowBand & band : bands) {
+        metrics.deadEnds += band.deadEnds;
+        metrics.junctions += band.junctions;
+    }
+
+    uint64_t distance;
+    uint64_t farCell = findFarthestCell(maze, 0, distance);
+    findFarthestCell(maze, farCell, metrics.diameter);
+
+    string path;
+    uint64_t cellsVisited;
+    metrics.solvable = solveMaze(maze, 0, maze.numCells() - 1, path, cellsVisited);
+    if (metrics.solvable) {
+        metrics.solutionLength = path.size();
+        metrics.solutionTurns = countTurns(path);
+    }
+    return metrics;
+}
+
+bool saveMetrics(const mazeMetrics & metrics, const string & filename) {
+    ofstream output(filename.c_str());
+    output << "{\"width\": " << metrics.width
+           << ", \"height\": " << metrics.height
+           << ", \"deadEnds\": " << metrics.deadEnds
+           << ", \"junctions\": " << metrics.junctions
+           << ", \"diameter\": " << metrics.diameter
+           << ", \"solvable\": " << (metrics.solvable ? "true" : "false")
+           << ", \"solutionLength\": " << metrics.solutionLength
+           << ", \"solutionTurns\": " << metrics.solutionTurns << "}" << endl;
+    return !output.fail();
+}
+
+/*
+ * This method classifies 64 cells at once. Four masks are built with a bit set for every cell open to the east, west, south
+ * and north, then added together bit by bit: the sums of the pairs (east, west) and (south, north) each give a low bit and a
+ * carry, and from those the cells with exactly one opening and the cells with three or more fall out with a few logical
+ * operations. The west and north masks come from the east bits of the previous column and the south bits of the previous row,
+ * and the borders of the maze are always closed.
+ */
+void findDeadEndsAndJunctions(const MazeBitplanes & maze, uint64_t row, uint64_t word, uint64_t & deadEnds,
+                              uint64_t & junctions) {
+    uint64_t rowWords = maze.wordsPerRow();
+    const uint64_t *east = maze.eastRow(row);
+    uint64_t valid = word + 1 < rowWords ? ~0ULL : validCellMask(maze.width(), word);
+    uint64_t lastColumn = word + 1 < rowWords ? 0 : (valid >> 1) + 1;
+    uint64_t eastOpen = ~east[word] & valid & ~lastColumn;
+    uint64_t westWalls = (east[word] << 1) | (word > 0 ? east[word - 1] >> 63 : 1);
+    uint64_t westOpen = ~westWalls & valid;
+    uint64_t southOpen = row + 1 == maze.height() ? 0 : ~maze.southRow(row)[word] & valid;
+    uint64_t northOpen = row == 0 ? 0 : ~maze.southRow(row - 1)[word] & valid;
+
+    uint64_t sumEW = eastOpen ^ westOpen;
+    uint64_t carryEW = eastOpen & westOpen;
+    uint64_t sumSN = southOpen ^ northOpen;
+    uint64_t carrySN = southOpen & northOpen;
+    deadEnds = (sumEW ^ sumSN) & ~(carryEW | carrySN);
+    junctions = (carryEW & (carrySN | sumSN)) | (carrySN & sumEW);
+}
+
+/*
+ * This method counts the dead ends and junctions in one band of rows, 64 cells at a time, and adds them to the band's totals.
+ */
+static void countBandOpenings(const MazeBitplanes & maze, rowBand & band) {
+    for (uint64_t row = band.firstRow; row < band.endRow; row++) {
+        for (uint64_t word = 0; word < maze.wordsPerRow(); word++) {
+            uint64_t deadEnds, junctions;
+            findDeadEndsAndJunctions(maze, row, word, deadEnds, junctions);
+            band.deadEnds += __builtin_popcountll(deadEnds);
+            band.junctions += __builtin_popcountll(junctions);
+        }
+    }
+}
+
+/*
+ * This method runs a breadth-first search from the start cell one level at a time, keeping a single bit per cell to remember
+ * which cells have been reached. It returns the last cell reached and sets distance to the number of moves needed to get there,
+ * which is as far from the start as any cell in the maze.
+ */
+static uint64_t findFarthestCell(const MazeBitplanes & maze, uint64_t start, uint64_t & distance) {
+    uint64_t width = maze.width();
+    vector<uint64_t> reached((maze.numCells() + 63) / 64, 0);
+    vector<uint64_t> frontier(1, start);
+    vector<uint64_t> nextFrontier;
+    reached[start / 64] |= 1ULL << (start % 64);
+    uint64_t farCell = start;
+    distance = 0;
+    while (true) {
+        nextFrontier.clear();
+        for (uint64_t cellIndex : frontier) {
+            uint64_t row = cellIndex / width;
+            uint64_t col = cellIndex % width;
+            uint64_t neighbours[4];
+            int numNeighbours = 0;
+            if (col + 1 < width && !maze.hasEastWall(row, col)) neighbours[numNeighbours++] = cellIndex + 1;
+            if (row + 1 < maze.height() && !maze.hasSouthWall(row, col)) neighbours[numNeighbours++] = cellIndex + width;
+            if (col > 0 && !maze.hasEastWall(row, col - 1)) neighbours[numNeighbours++] = cellIndex - 1;
+            if (row > 0 && !maze.hasSouthWall(row - 1, col)) neighbours[numNeighbours++] = cellIndex - width;
+            for (int i = 0; i < numNeighbours; i++) {
+                uint64_t neighbour = neighbours[i];
+                uint64_t bit = 1ULL << (neighbour % 64);
+                if (reached[neighbour / 64] & bit) continue;
+                reached[neighbour / 64] |= bit;
+                nextFrontier.push_back(neighbour);
+            }
+        }
+        if (nextFrontier.empty()) break;
+        farCell = nextFrontier.back();
+        distance++;
+        frontier.swap(nextFrontier);
+    }
+    return farCell;
+}
+
+/*
+ * This method counts the moves in a path that change direction from the move before.
+ */
+static uint64_t countTurns(const string & path) {
+    uint64_t turns = 0;
+    for (size_t i = 1; i < path.size(); i++) {
+        if (path[i] != path[i - 1]) turns++;
+    }
+    return turns;
+}
+
+/*
+ * This method returns a mask of the bits in the given word of a row that belong to real cells rather than padding.
+ */
+static uint64_t validCellMask(uint64_t width, uint64_t word) {
+    uint64_t cellsInWord = width - 64 * word;
+    return cellsInWord >= 64 ? ~0ULL : (1ULL << cellsInWord) - 1;
+}
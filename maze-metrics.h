@@ -0,0 +1,69 @@
+/**
+ * File: maze-metrics.h
+ * --------------------
+ * Declares functions that measure the shape of a maze stored as MazeBitplanes,
+ * for judging whether a generated maze is worth keeping.
+ */
+
+#ifndef _maze_metrics_
+#define _maze_metrics_
+
+#include <cstdint>
+#include <string>
+#include "maze-bitplanes.h"
+
+/*
+ * Type: mazeMetrics
+ * -----------------
+ * The statistics measured for one maze. A dead end is a cell with exactly one
+ * opening and a junction is a cell with three or more. The diameter is the
+ * length, in moves, of the longest shortest path between two cells. The
+ * solution runs from the top-left cell to the bottom-right cell, and a turn is
+ * any move in a different direction from the move before it.
+ */
+struct mazeMetrics {
+    uint64_t width;
+    uint64_t height;
+    uint64_t deadEnds;
+    uint64_t junctions;
+    uint64_t diameter;
+    bool solvable;
+    uint64_t solutionLength;
+    uint64_t solutionTurns;
+};
+
+/*
+ * Function: measureMaze
+ * Usage: mazeMetrics metrics = measureMaze(maze, numThreads);
+ * -----------------------------------------------------------
+ * Measures a maze. Dead ends and junctions are counted in a single pass over
+ * the bitplanes, split into one band of rows per thread. The diameter comes
+ * from two breadth-first searches: the first finds the cell farthest from the
+ * top-left corner and the second the cell farthest from that one. This is
+ * exact for perfect mazes, and a lower bound for mazes with loops. The
+ * solution comes from solveMaze (see maze-solver.h).
+ */
+mazeMetrics measureMaze(const MazeBitplanes & maze, int numThreads);
+
+/*
+ * Function: findDeadEndsAndJunctions
+ * Usage: findDeadEndsAndJunctions(maze, row, word, deadEnds, junctions);
+ * ----------------------------------------------------------------------
+ * Looks at the 64 cells of one row covered by one word of the bitplanes (see
+ * MazeBitplanes::eastRow) and sets deadEnds and junctions to masks with a bit
+ * set for every one of those cells with exactly one opening and with three or
+ * more. Only reads the given row and the row above it.
+ */
+void findDeadEndsAndJunctions(const MazeBitplanes & maze, uint64_t row, uint64_t word, uint64_t & deadEnds,
+                              uint64_t & junctions);
+
+/*
+ * Function: saveMetrics
+ * Usage: if (!saveMetrics(metrics, filename)) ...
+ * -----------------------------------------------
+ * Writes the metrics to a file as a single JSON object whose keys match the
+ * fields of mazeMetrics. Returns false if the file could not be written.
+ */
+bool saveMetrics(const mazeMetrics & metrics, const std::string & filename);
+
+#endif
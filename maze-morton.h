@@ -0,0 +1,161 @@
+/**
+ * File: maze-morton.h
+ * -------------------
+ * Defines an optional Morton (Z-order) numbering of the cells of a maze, for
+ * the per-cell working arrays of the headless generators and the solver.
+ * Cells that are close in the maze, above and below as well as side by side,
+ * get close numbers, so searches and random walks that move around the maze
+ * touch fewer cache lines than they would with cells numbered row by row.
+ */
+
+#ifndef _maze_morton_
+#define _maze_morton_
+
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/*
+ * Type: MazeCellLayout
+ * --------------------
+ * How a working array numbers the cells of a maze: row by row, as cell
+ * indices are everywhere else (see maze-bitplanes.h), or in Morton order.
+ */
+enum MazeCellLayout {
+    ROW_MAJOR_LAYOUT,
+    MORTON_LAYOUT
+};
+
+/*
+ * Classes: RowMajorCellOrder, MortonCellOrder
+ * -------------------------------------------
+ * Number the cells of a width-by-height maze in each of the layouts above.
+ * The two classes have the same methods, so code that works on cells can be
+ * written once as a template over the order and compiled for each, leaving
+ * no test of the layout on its inner loop.
+ *
+ * The Morton order splits the maze into square tiles of up to 256 x 256
+ * cells, numbered row by row, and numbers the cells within each tile in
+ * Z-order, by interleaving the bits of their row and column within the tile.
+ * Tiles keep the numbers dense whatever the shape of the maze: the tiles
+ * along the right and bottom edges are padded out to full size, so a few
+ * numbers go unused, but never more than the maze would need for one more
+ * row and column of tiles. The tile side is the largest power of two no
+ * bigger than the shorter side of the maze, so long thin mazes are not
+ * padded out to squares.
+ */
+class RowMajorCellOrder {
+public:
+
+    /*
+     * Constructor: RowMajorCellOrder
+     * Usage: RowMajorCellOrder order(maze.width(), maze.height());
+     * ------------------------------------------------------------
+     * Creates the numbering for a maze of the given size.
+     */
+    RowMajorCellOrder(uint64_t width, uint64_t height);
+
+    /*
+     * Method: size
+     * Usage: vector<uint64_t> visited((order.size() + 63) / 64);
+     * ----------------------------------------------------------
+     * Returns how many numbers the order uses, counting any unused numbers of
+     * padded tiles, so arrays indexed by it need this many entries.
+     */
+    uint64_t size() const;
+
+    /*
+     * Methods: indexOf, indexOfCell
+     * Usage: uint64_t index = order.indexOf(row, col);
+     * ------------------------------------------------
+     * Return the number the order gives the cell in the given row and column,
+     * or the cell with the given row-by-row index.
+     */
+    uint64_t indexOf(uint64_t row, uint64_t col) const;
+    uint64_t indexOfCell(uint64_t cellIndex) const;
+
+private:
+    uint64_t mazeWidth;
+    uint64_t numIndices;
+};
+
+class MortonCellOrder {
+public:
+    MortonCellOrder(uint64_t width, uint64_t height);
+    uint64_t size() const;
+    uint64_t indexOf(uint64_t row, uint64_t col) const;
+    uint64_t indexOfCell(uint64_t cellIndex) const;
+
+private:
+    uint64_t mazeWidth;
+    uint64_t tilesWide;
+    uint64_t numIndices;
+    int tileBits;
+};
+
+/*
+ * Implementation notes
+ * --------------------
+ * indexOf runs once per step of every walk and search that uses an order, so
+ * everything is defined inline here. With BMI2 the bits of the row and column
+ * are spread apart with one pdep instruction each; otherwise they are spread
+ * with the usual sequence of shifts and masks.
+ */
+
+static const int kMaxMortonTileBits = 8;
+
+inline uint64_t spreadMortonBits(uint64_t value) {
+#ifdef __BMI2__
+    return _pdep_u32((uint32_t) value, 0x55555555);
+#else
+    value = (value | (value << 4)) & 0x0f0f;
+    value = (value | (value << 2)) & 0x3333;
+    return (value | (value << 1)) & 0x5555;
+#endif
+}
+
+inline RowMajorCellOrder::RowMajorCellOrder(uint64_t width, uint64_t height) {
+    mazeWidth = width;
+    numIndices = width * height;
+}
+
+inline uint64_t RowMajorCellOrder::size() const {
+    return numIndices;
+}
+
+inline uint64_t RowMajorCellOrder::indexOf(uint64_t row, uint64_t col) const {
+    return row * mazeWidth + col;
+}
+
+inline uint64_t RowMajorCellOrder::indexOfCell(uint64_t cellIndex) const {
+    return cellIndex;
+}
+
+inline MortonCellOrder::MortonCellOrder(uint64_t width, uint64_t height) {
+    mazeWidth = width;
+    tileBits = 0;
+    while (tileBits < kMaxMortonTileBits && (2ULL << tileBits) <= width && (2ULL << tileBits) <= height) {
+        tileBits++;
+    }
+    uint64_t tileSide = 1ULL << tileBits;
+    tilesWide = (width + tileSide - 1) / tileSide;
+    uint64_t tilesTall = (height + tileSide - 1) / tileSide;
+    numIndices = (tilesWide * tilesTall) << (2 * tileBits);
+}
+
+inline uint64_t MortonCellOrder::size() const {
+    return numIndices;
+}
+
+inline uint64_t MortonCellOrder::indexOf(uint64_t row, uint64_t col) const {
+    uint64_t tileMask = (1ULL << tileBits) - 1;
+    uint64_t tile = (row >> tileBits) * tilesWide + (col >> tileBits);
+    return (tile << (2 * tileBits)) | spreadMortonBits(col & tileMask) | (spreadMortonBits(row & tileMask) << 1);
+}
+
+inline uint64_t MortonCellOrder::indexOfCell(uint64_t cellIndex) const {
+    return indexOf(cellIndex / mazeWidth, cellIndex % mazeWidth);
+}
+
+#endif
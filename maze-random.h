@@ -0,0 +1,178 @@
+/**
+ * File: maze-random.h
+ * -------------------
+ * Defines a small, fast, seedable pseudorandom number generator for the maze
+ * generators, along with an in-place Fisher-Yates shuffle driven by it and a
+ * counter-based generator for values that must not depend on call order.
+ */
+
+#ifndef _maze_random_
+#define _maze_random_
+
+#include <cstdint>
+
+/*
+ * Class: MazeRandom
+ * -----------------
+ * A xoshiro256** generator. Two generators built from the same seed produce
+ * the same sequence, which is what makes a maze reproducible from its seed.
+ * It is far cheaper per call than randomInteger, and its state is a handful
+ * of words, so every thread or maze can own one.
+ */
+class MazeRandom {
+public:
+
+    /*
+     * Constructor: MazeRandom
+     * Usage: MazeRandom generator(seed);
+     * ----------------------------------
+     * Creates a generator whose sequence is determined entirely by seed.
+     */
+    explicit MazeRandom(uint64_t seed = 0);
+
+    /*
+     * Method: next
+     * Usage: uint64_t bits = generator.next();
+     * ----------------------------------------
+     * Returns 64 uniformly distributed random bits.
+     */
+    uint64_t next();
+
+    /*
+     * Method: nextBelow
+     * Usage: uint64_t index = generator.nextBelow(count);
+     * ---------------------------------------------------
+     * Returns an integer chosen uniformly from 0 through bound - 1. The bound
+     * must be positive.
+     */
+    uint64_t nextBelow(uint64_t bound);
+
+    /*
+     * Method: jump
+     * Usage: generator.jump();
+     * ------------------------
+     * Advances the generator by 2^128 steps. Copies of one generator that
+     * have been jumped different numbers of times produce sequences that
+     * never overlap in practice, which gives every thread a stream of its own.
+     */
+    void jump();
+
+private:
+    uint64_t state[4];
+};
+
+/*
+ * Function: shuffleInPlace
+ * Usage: shuffleInPlace(&walls[0], walls.size(), generator);
+ * ----------------------------------------------------------
+ * Puts the count items starting at items into a uniformly random order using
+ * the Fisher-Yates shuffle: each position, from the last to the second, is
+ * swapped with a randomly chosen position at or before it. Runs in O(count)
+ * time and needs no memory beyond the array itself.
+ */
+template <typename ValueType>
+void shuffleInPlace(ValueType *items, uint64_t count, MazeRandom & generator);
+
+/*
+ * Function: counterRandom
+ * Usage: uint64_t weight = counterRandom(seed, wallIndex);
+ * --------------------------------------------------------
+ * Returns 64 random bits determined entirely by the seed and the counter, so
+ * the value for any one counter can be computed on its own, by any thread, in
+ * any order. Different counters give values that behave as if they were
+ * independent and uniformly distributed.
+ */
+uint64_t counterRandom(uint64_t seed, uint64_t counter);
+
+/*
+ * Implementation notes
+ * --------------------
+ * The seed is spread over the four words of state with splitmix64, which
+ * guarantees the state is never all zeros. nextBelow uses Lemire's
+ * multiply-and-shift reduction, rejecting the few values that would bias it.
+ * counterRandom is Philox2x64-10: the counter and a zero word are put through
+ * ten rounds that each multiply one word into a 128-bit product and mix the
+ * halves with the other word and a key that starts at the seed and grows by a
+ * constant every round.
+ */
+
+inline MazeRandom::MazeRandom(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t mixed = seed;
+        mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+        state[i] = mixed ^ (mixed >> 31);
+    }
+}
+
+inline uint64_t MazeRandom::next() {
+    uint64_t product = state[1] * 5;
+    uint64_t result = ((product << 7) | (product >> 57)) * 9;
+    uint64_t shifted = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = (state[3] << 45) | (state[3] >> 19);
+    return result;
+}
+
+inline uint64_t MazeRandom::nextBelow(uint64_t bound) {
+    unsigned __int128 product = (unsigned __int128) next() * bound;
+    uint64_t low = (uint64_t) product;
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (unsigned __int128) next() * bound;
+            low = (uint64_t) product;
+        }
+    }
+    return (uint64_t) (product >> 64);
+}
+
+inline void MazeRandom::jump() {
+    static const uint64_t jumpPolynomial[4] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    uint64_t jumped[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (jumpPolynomial[i] & (1ULL << bit)) {
+                for (int j = 0; j < 4; j++) {
+                    jumped[j] ^= state[j];
+                }
+            }
+            next();
+        }
+    }
+    for (int j = 0; j < 4; j++) {
+        state[j] = jumped[j];
+    }
+}
+
+inline uint64_t counterRandom(uint64_t seed, uint64_t counter) {
+    uint64_t low = counter;
+    uint64_t high = 0;
+    uint64_t key = seed;
+    for (int round = 0; round < 10; round++) {
+        unsigned __int128 product = (unsigned __int128) 0xd2b74407b1ce6e93ULL * low;
+        low = (uint64_t) (product >> 64) ^ key ^ high;
+        high = (uint64_t) product;
+        key += 0x9e3779b97f4a7c15ULL;
+    }
+    return low;
+}
+
+template <typename ValueType>
+void shuffleInPlace(ValueType *items, uint64_t count, MazeRandom & generator) {
+    for (uint64_t i = count; i > 1; i--) {
+        uint64_t j = generator.nextBelow(i);
+        ValueType temp = items[i - 1];
+        items[i - 1] = items[j];
+        items[j] = temp;
+    }
+}
+
+#endif
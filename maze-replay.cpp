@@ -0,0 +1,191 @@
+/**
+ * File: maze-replay.cpp
+ * ---------------------
+ * Implements the replay log and cursor declared in maze-replay.h.
+ */
+
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+#include "maze-replay.h"
+#include "maze-bitplanes.h"
+
+//Prototypes
+static uint64_t decodeVarint(const vector<uint8_t> & bytes, uint64_t & position);
+static bool isInteriorWall(uint64_t wallIndex, uint64_t width, uint64_t height);
+static const char replayFileMagic[8] = { 'M', 'A', 'Z', 'E', 'L', 'O', 'G', '1' };
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "replay files are in memory order and must be little-endian");
+
+MazeReplayLog::MazeReplayLog(uint64_t width, uint64_t height, uint64_t seed) {
+    mazeWidth = width;
+    mazeHeight = height;
+    mazeSeed = seed;
+    removals = 0;
+    lastWall = 0;
+}
+
+/*
+ * The difference is taken modulo 2^64 and reinterpreted as signed. Zigzag encoding then interleaves the signs, mapping 0, -1,
+ * 1, -2, ... to 0, 1, 2, 3, ..., so a short hop either way takes a single byte.
+ */
+void MazeReplayLog::addRemoval(uint64_t wallIndex) {
+    int64_t delta = (int64_t) (wallIndex - lastWall);
+    uint64_t zigzag = ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63);
+    while (zigzag >= 0x80) {
+        bytes.push_back((zigzag & 0x7f) | 0x80);
+        zigzag >>= 7;
+    }
+    bytes.push_back(zigzag);
+    lastWall = wallIndex;
+    removals++;
+}
+
+uint64_t MazeReplayLog::width() const {
+    return mazeWidth;
+}
+
+uint64_t MazeReplayLog::height() const {
+    return mazeHeight;
+}
+
+uint64_t MazeReplayLog::seed() const {
+    return mazeSeed;
+}
+
+uint64_t MazeReplayLog::numRemovals() const {
+    return removals;
+}
+
+uint64_t MazeReplayLog::numBytes() const {
+    return bytes.size();
+}
+
+bool MazeReplayLog::save(const string & filename) const {
+    replayFileHeader header;
+    memcpy(header.magic, replayFileMagic, sizeof(header.magic));
+    header.width = mazeWidth;
+    header.height = mazeHeight;
+    header.seed = mazeSeed;
+    header.numRemovals = removals;
+    header.numBytes = bytes.size();
+    ofstream file(filename.c_str(), ios::binary | ios::trunc);
+    file.write((const char *) &header, sizeof(header));
+    if (!bytes.empty()) file.write((const char *) bytes.data(), bytes.size());
+    file.close();
+    return !file.fail();
+}
+
+/*
+ * The length of the log is checked against what is left of the file before any memory is set aside for it, so a damaged header
+ * cannot ask for more than the file holds. The whole log is then decoded once, to check that it holds exactly the number of
+ * removals the header says and that every one of them is a wall between two cells of the maze, and to find the last wall, so
+ * that more removals can be added to a loaded log.
+ */
+bool MazeReplayLog::load(const string & filename) {
+    ifstream file(filename.c_str(), ios::binary | ios::ate);
+    uint64_t fileSize = file.tellg();
+    file.seekg(0);
+    replayFileHeader header;
+    file.read((char *) &header, sizeof(header));
+    if (file.fail() || memcmp(header.magic, replayFileMagic, sizeof(header.magic)) != 0) return false;
+    if (header.numBytes != fileSize - sizeof(header)) return false;
+    vector<uint8_t> logBytes(header.numBytes);
+    if (header.numBytes > 0) file.read((char *) logBytes.data(), header.numBytes);
+    if (file.fail()) return false;
+    uint64_t wallIndex = 0;
+    uint64_t numRemovals = 0;
+    for (uint64_t position = 0; position < logBytes.size(); numRemovals++) {
+        uint64_t zigzag = decodeVarint(logBytes, position);
+        if (position > logBytes.size()) return false;
+        wallIndex += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        if (!isInteriorWall(wallIndex, header.width, header.height)) return false;
+    }
+    if (numRemovals != header.numRemovals) return false;
+    mazeWidth = header.width;
+    mazeHeight = header.height;
+    mazeSeed = header.seed;
+    removals = numRemovals;
+    lastWall = wallIndex;
+    bytes.swap(logBytes);
+    return true;
+}
+
+MazeReplayCursor::MazeReplayCursor(const MazeReplayLog & log) : replay(log) {
+    step = 0;
+    offset = 0;
+    currentWall = 0;
+}
+
+uint64_t MazeReplayCursor::position() const {
+    return step;
+}
+
+bool MazeReplayCursor::stepForward(uint64_t & wallIndex) {
+    if (step == replay.removals) return false;
+    currentWall += readDelta(offset);
+    wallIndex = currentWall;
+    step++;
+    return true;
+}
+
+/*
+ * The byte before the cursor ends the previous removal. Its first byte is found by walking back over every byte before that
+ * with its high bit set, since those are all continuation bytes of the same varint.
+ */
+bool MazeReplayCursor::stepBack(uint64_t & wallIndex) {
+    if (step == 0) return false;
+    wallIndex = currentWall;
+    uint64_t start = offset - 1;
+    while (start > 0 && (replay.bytes[start - 1] & 0x80)) start--;
+    offset = start;
+    currentWall -= readDelta(start);
+    step--;
+    return true;
+}
+
+/*
+ * This method decodes the removal starting at position, moves position past it, and returns the difference it records, as a
+ * number to be added to the previous wall index modulo 2^64.
+ */
+uint64_t MazeReplayCursor::readDelta(uint64_t & position) const {
+    uint64_t zigzag = decodeVarint(replay.bytes, position);
+    return (zigzag >> 1) ^ (0 - (zigzag & 1));
+}
+
+/*
+ * This method decodes the varint starting at position and moves position past it. A varint that is cut off by the end of the
+ * bytes, or that does not fit in 64 bits, either because it runs past ten bytes or because its tenth byte holds more than the
+ * top bit, leaves position one past the end.
+ */
+static uint64_t decodeVarint(const vector<uint8_t> & bytes, uint64_t & position) {
+    uint64_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (position >= bytes.size() || shift >= 64) {
+            position = bytes.size() + 1;
+            return value;
+        }
+        uint8_t byte = bytes[position++];
+        if (shift == 63 && (byte & 0x7e) != 0) {
+            position = bytes.size() + 1;
+            return value;
+        }
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+}
+
+/*
+ * This method returns whether a wall index names a wall between two cells of a maze of the given size: its cell must lie on
+ * the grid, and the cell on the other side of it must too. The row is found by dividing rather than by multiplying the width
+ * and height, which could overflow.
+ */
+static bool isInteriorWall(uint64_t wallIndex, uint64_t width, uint64_t height) {
+    if (width == 0) return false;
+    uint64_t cellIndex = wallIndex >> 1;
+    uint64_t row = cellIndex / width;
+    uint64_t col = cellIndex % width;
+    if (row >= height) return false;
+    if ((wallIndex & 1) == kEastWall) return col + 1 < width;
+    return row + 1 < height;
+}
@@ -0,0 +1,150 @@
+/**
+ * File: maze-replay.h
+ * -------------------
+ * Defines a compact log of the order in which a generator knocked down the
+ * walls of a maze, so the maze can be generated at full speed and its
+ * construction animated later, at any speed, in either direction.
+ *
+ * Each removal is stored as the difference between its wall index (see
+ * makeWallIndex in maze-bitplanes.h) and the one before it, zigzag encoded so
+ * that small steps either way are small numbers, then written as a varint:
+ * seven bits per byte, low bits first, with the high bit of every byte but
+ * the last set. Since only the last byte of each removal has its high bit
+ * clear, the log can be read backward as easily as forward.
+ *
+ * A replay file is a 48-byte replayFileHeader followed by the bytes of the
+ * log. The header is written just as it sits in memory, so, like maze files,
+ * replay files are only written on little-endian machines, where the header
+ * is little-endian; the log is bytes already.
+ */
+
+#ifndef _maze_replay_
+#define _maze_replay_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Type: replayFileHeader
+ * ----------------------
+ * The first 48 bytes of every replay file.
+ */
+struct replayFileHeader {
+    char magic[8];
+    uint64_t width;
+    uint64_t height;
+    uint64_t seed;
+    uint64_t numRemovals;
+    uint64_t numBytes;
+};
+
+/*
+ * Class: MazeReplayLog
+ * --------------------
+ * Records the walls knocked down while a maze of a given size was generated
+ * from a given seed, in the order they came down.
+ */
+class MazeReplayLog {
+public:
+
+    /*
+     * Constructor: MazeReplayLog
+     * Usage: MazeReplayLog replay(width, height, seed);
+     * -------------------------------------------------
+     * Creates an empty log for a maze of the given size and seed.
+     */
+    MazeReplayLog(uint64_t width = 0, uint64_t height = 0, uint64_t seed = 0);
+
+    /*
+     * Method: addRemoval
+     * Usage: replay.addRemoval(wallIndex);
+     * ------------------------------------
+     * Appends the next wall to come down.
+     */
+    void addRemoval(uint64_t wallIndex);
+
+    /*
+     * Methods: width, height, seed, numRemovals, numBytes
+     * Usage: uint64_t steps = replay.numRemovals();
+     * ---------------------------------------------
+     * Return the size and seed of the maze, the number of removals recorded,
+     * and the number of bytes they take up.
+     */
+    uint64_t width() const;
+    uint64_t height() const;
+    uint64_t seed() const;
+    uint64_t numRemovals() const;
+    uint64_t numBytes() const;
+
+    /*
+     * Methods: save, load
+     * Usage: if (replay.save(filename)) ...
+     * -------------------------------------
+     * Write the log to a replay file, or replace it with one read from a
+     * replay file. Return false if the file cannot be written, or cannot be
+     * read, is not a replay file, or records a wall that is not between two
+     * cells of its maze.
+     */
+    bool save(const std::string & filename) const;
+    bool load(const std::string & filename);
+
+private:
+    friend class MazeReplayCursor;
+    uint64_t mazeWidth;
+    uint64_t mazeHeight;
+    uint64_t mazeSeed;
+    uint64_t removals;
+    uint64_t lastWall;
+    std::vector<uint8_t> bytes;
+};
+
+/*
+ * Class: MazeReplayCursor
+ * -----------------------
+ * A position in a MazeReplayLog, from 0 (before the first removal) to
+ * numRemovals (after the last), which can step either way through the log in
+ * constant time per step. The log must outlive the cursor and must not change
+ * while the cursor is in use.
+ */
+class MazeReplayCursor {
+public:
+
+    /*
+     * Constructor: MazeReplayCursor
+     * Usage: MazeReplayCursor cursor(replay);
+     * ---------------------------------------
+     * Creates a cursor at the start of the log.
+     */
+    explicit MazeReplayCursor(const MazeReplayLog & log);
+
+    /*
+     * Method: position
+     * Usage: uint64_t step = cursor.position();
+     * -----------------------------------------
+     * Returns how many removals lie before the cursor.
+     */
+    uint64_t position() const;
+
+    /*
+     * Methods: stepForward, stepBack
+     * Usage: while (cursor.stepForward(wallIndex)) view.removeWall(...);
+     * ------------------------------------------------------------------
+     * Move the cursor one removal forward or back and set wallIndex to the
+     * wall that removal knocked down: the wall to take down when stepping
+     * forward, or to put back up when stepping back. Return false, leaving
+     * the cursor alone, at the end or the start of the log.
+     */
+    bool stepForward(uint64_t & wallIndex);
+    bool stepBack(uint64_t & wallIndex);
+
+private:
+    const MazeReplayLog & replay;
+    uint64_t step;
+    uint64_t offset;
+    uint64_t currentWall;
+
+    uint64_t readDelta(uint64_t & position) const;
+};
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * File: maze-solver.cpp
+ * ---------------------
+ * Implements the bidirectional breadth-first maze solver.
+ */
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "maze-solver.h"
+
+/*
+ * Type: searchSide
+ * ----------------
+ * One of the two searches run by solveMaze: a bitset of the cells it has reached, and the cells on its current frontier.
+ */
+struct searchSide {
+    vector<uint64_t> reached;
+    vector<uint64_t> frontier;
+};
+
+//Prototypes
+template <typename CellOrder>
+static bool searchMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, string & path, uint64_t & cellsVisited,
+                       const CellOrder & order);
+template <typename CellOrder>
+static bool expandFrontier(const MazeBitplanes & maze, const CellOrder & order, searchSide & side,
+                           const searchSide & otherSide, vector<uint8_t> & parents, uint64_t & cellsVisited,
+                           uint64_t & meetingCell, int & meetingDirection);
+static bool isOpen(const MazeBitplanes & maze, uint64_t row, uint64_t col, int direction);
+static bool hasReached(const searchSide & side, uint64_t cellIndex);
+static void markReached(searchSide & side, uint64_t cellIndex);
+static int getParent(const vector<uint8_t> & parents, uint64_t cellIndex);
+static void setParent(vector<uint8_t> & parents, uint64_t cellIndex, int direction);
+static uint64_t stepFrom(const MazeBitplanes & maze, uint64_t cellIndex, int direction);
+static const char directionLetters[4] = { 'E', 'S', 'W', 'N' };
+static const int rowStep[4] = { 0, 1, 0, -1 };
+static const int colStep[4] = { 1, 0, -1, 0 };
+
+/*
+ * Directions are numbered east, south, west, north, so the opposite of direction d is (d + 2) % 4. Every cell a search reaches
+ * records the direction that leads back to the cell it was reached from. When the searches meet, the path is the start's
+ * chain of directions, reversed, then the step across the meeting point, then the exit's chain followed forward.
+ */
+bool solveMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, string & path, uint64_t & cellsVisited) {
+    return solveMaze(maze, start, exit, path, cellsVisited, ROW_MAJOR_LAYOUT);
+}
+
+bool solveMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, string & path, uint64_t & cellsVisited,
+               MazeCellLayout layout) {
+    if (layout == MORTON_LAYOUT) {
+        return searchMaze(maze, start, exit, path, cellsVisited, MortonCellOrder(maze.width(), maze.height()));
+    }
+    return searchMaze(maze, start, exit, path, cellsVisited, RowMajorCellOrder(maze.width(), maze.height()));
+}
+
+/*
+ * This method is the search itself, with the bits kept for each cell numbered by the given order. The frontiers always hold
+ * row-by-row cell indices; the order is only applied when a cell's bits are looked up.
+ */
+template <typename CellOrder>
+static bool searchMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, string & path, uint64_t & cellsVisited,
+                       const CellOrder & order) {
+    path = "";
+    cellsVisited = 1;
+    if (start == exit) return true;
+    searchSide fromStart;
+    searchSide fromExit;
+    fromStart.reached.assign((order.size() + 63) / 64, 0);
+    fromExit.reached.assign((order.size() + 63) / 64, 0);
+    vector<uint8_t> parents((order.size() + 3) / 4, 0);
+    markReached(fromStart, order.indexOfCell(start));
+    markReached(fromExit, order.indexOfCell(exit));
+    fromStart.frontier.push_back(start);
+    fromExit.frontier.push_back(exit);
+    cellsVisited = 2;
+
+    uint64_t meetingCell = 0;
+    int meetingDirection = 0;
+    bool startSideMet = false;
+    bool met = false;
+    while (!met && !fromStart.frontier.empty() && !fromExit.frontier.empty()) {
+        if (fromStart.frontier.size() <= fromExit.frontier.size()) {
+            met = expandFrontier(maze, order, fromStart, fromExit, parents, cellsVisited, meetingCell, meetingDirection);
+            startSideMet = true;
+        } else {
+            met = expandFrontier(maze, order, fromExit, fromStart, parents, cellsVisited, meetingCell, meetingDirection);
+            startSideMet = false;
+        }
+    }
+    if (!met) return false;
+
+    uint64_t startSideCell = meetingCell;
+    uint64_t exitSideCell = stepFrom(maze, meetingCell, meetingDirection);
+    int crossing = meetingDirection;
+    if (!startSideMet) {
+        swap(startSideCell, exitSideCell);
+        crossing = (meetingDirection + 2) % 4;
+    }
+    for (uint64_t cellIndex = startSideCell; cellIndex != start; ) {
+        int back = getParent(parents, order.indexOfCell(cellIndex));
+        path += directionLetters[(back + 2) % 4];
+        cellIndex = stepFrom(maze, cellIndex, back);
+    }
+    reverse(path.begin(), path.end());
+    path += directionLetters[crossing];
+    for (uint64_t cellIndex = exitSideCell; cellIndex != exit; ) {
+        int forward = getParent(parents, order.indexOfCell(cellIndex));
+        path += directionLetters[forward];
+        cellIndex = stepFrom(maze, cellIndex, forward);
+    }
+    return true;
+}
+
+/*
+ * This method advances one search by a full level: every open neighbour of the frontier that this search has not reached yet
+ * becomes part of the next frontier. If a neighbour has already been reached by the other search, the two have met; the cell
+ * being expanded and the direction of the step are recorded, and the method returns true right away.
+ */
+template <typename CellOrder>
+static bool expandFrontier(const MazeBitplanes & maze, const CellOrder & order, searchSide & side,
+                           const searchSide & otherSide, vector<uint8_t> & parents, uint64_t & cellsVisited,
+                           uint64_t & meetingCell, int & meetingDirection) {
+    vector<uint64_t> nextFrontier;
+    for (uint64_t cellIndex : side.frontier) {
+        uint64_t row = cellIndex / maze.width();
+        uint64_t col = cellIndex % maze.width();
+        for (int direction = 0; direction < 4; direction++) {
+            if (!isOpen(maze, row, col, direction)) continue;
+            uint64_t neighbour = stepFrom(maze, cellIndex, direction);
+            uint64_t index = order.indexOf(row + rowStep[direction], col + colStep[direction]);
+            if (hasReached(side, index)) continue;
+            if (hasReached(otherSide, index)) {
+                meetingCell = cellIndex;
+                meetingDirection = direction;
+                return true;
+            }
+            markReached(side, index);
+            setParent(parents, index, (direction + 2) % 4);
+            nextFrontier.push_back(neighbour);
+            cellsVisited++;
+        }
+    }
+    side.frontier.swap(nextFrontier);
+    return false;
+}
+
+/*
+ * This method returns whether a move in the given direction from a cell stays inside the maze and passes through no wall.
+ */
+static bool isOpen(const MazeBitplanes & maze, uint64_t row, uint64_t col, int direction) {
+    if (direction == 0) return col + 1 < maze.width() && !maze.hasEastWall(row, col);
+    if (direction == 1) return row + 1 < maze.height() && !maze.hasSouthWall(row, col);
+    if (direction == 2) return col > 0 && !maze.hasEastWall(row, col - 1);
+    return row > 0 && !maze.hasSouthWall(row - 1, col);
+}
+
+/*
+ * These methods read and write a search's bit for the cell with the given index in the order the search is using.
+ */
+static bool hasReached(const searchSide & side, uint64_t cellIndex) {
+    return (side.reached[cellIndex / 64] >> (cellIndex % 64)) & 1;
+}
+
+static void markReached(searchSide & side, uint64_t cellIndex) {
+    side.reached[cellIndex / 64] |= 1ULL << (cellIndex % 64);
+}
+
+/*
+ * These methods read and write the two-bit direction stored for each cell, four cells to a byte, again by the cell's index
+ * in the order the search is using.
+ */
+static int getParent(const vector<uint8_t> & parents, uint64_t cellIndex) {
+    return (parents[cellIndex / 4] >> (2 * (cellIndex % 4))) & 3;
+}
+
+static void setParent(vector<uint8_t> & parents, uint64_t cellIndex, int direction) {
+    int shift = 2 * (cellIndex % 4);
+    parents[cellIndex / 4] = (parents[cellIndex / 4] & ~(3 << shift)) | (direction << shift);
+}
+
+/*
+ * This method returns the index of the cell one step from a cell in the given direction.
+ */
+static uint64_t stepFrom(const MazeBitplanes & maze, uint64_t cellIndex, int direction) {
+    return cellIndex + colStep[direction] + rowStep[direction] * (int64_t) maze.width();
+}
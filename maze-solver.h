@@ -0,0 +1,46 @@
+/**
+ * File: maze-solver.h
+ * -------------------
+ * Declares a solver that finds the shortest path through a maze stored as
+ * MazeBitplanes.
+ */
+
+#ifndef _maze_solver_
+#define _maze_solver_
+
+#include <cstdint>
+#include <string>
+#include "maze-bitplanes.h"
+#include "maze-morton.h"
+
+/*
+ * Function: solveMaze
+ * Usage: if (solveMaze(maze, start, exit, path, cellsVisited)) ...
+ * ----------------------------------------------------------------
+ * Finds a shortest path from the cell with index start to the cell with index
+ * exit, moving only through missing walls. If there is one, path is set to
+ * the moves that follow it, one letter per move ('N', 'E', 'S' or 'W'), and
+ * the function returns true; otherwise it returns false. Either way,
+ * cellsVisited is set to the number of cells the search reached.
+ *
+ * The search is a breadth-first search run from both ends at once, always
+ * growing the smaller frontier, until the two meet. Each cell costs two bits
+ * to mark which search has reached it and two bits to remember the direction
+ * back toward the end it was reached from, so a 10^8-cell maze needs about
+ * 50 MB on top of the maze and the frontiers.
+ */
+bool solveMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, std::string & path, uint64_t & cellsVisited);
+
+/*
+ * Function: solveMaze
+ * Usage: if (solveMaze(maze, start, exit, path, cellsVisited, MORTON_LAYOUT)) ...
+ * -------------------------------------------------------------------------------
+ * Finds the same path as the version above, with the bits kept for each cell
+ * numbered in the given layout (see maze-morton.h). A search grows outward
+ * from its end in every direction at once, so with the Morton layout the
+ * cells it reaches next to each other usually share cache lines.
+ */
+bool solveMaze(const MazeBitplanes & maze, uint64_t start, uint64_t exit, std::string & path, uint64_t & cellsVisited,
+               MazeCellLayout layout);
+
+#endif